@@ -47,6 +47,8 @@ void lcdLinkInitialise(LCDInterface *interface) {
 	gpioWrite(&config->enOutput, 0);
 	gpioWrite(&config->rwOutput, 0);
 	gpioWrite(&config->rsOutput, 0);
+	
+	gpioBusInitialise(&config->__bus, &config->dataBus, &config->enOutput);
 }
 
 uint8_t lcdLinkGetDataWidth(LCDInterface *interface) {
@@ -71,21 +73,39 @@ void lcdLinkDataOut(LCDInterface *interface, LCDDataType dataType, uint8_t byteV
 	LCDParallelLinkConfig *config = (LCDParallelLinkConfig *) interface->linkConfig;
 	gpioWrite(&config->rsOutput, dataType);
 	gpioWrite(&config->rwOutput, LCD_Write);
-	gpioWrite(&config->enOutput, 1);
-
-	if (config->dataBus.count == 8) {
-		gpioWrite(&config->dataBus, byteValue);
+	
+	if (config->__bus.strobe) {
+		// E is on the data bus' port: each nibble or byte takes
+		// one store to write data and raise E, and one to lower it.
+		if (config->dataBus.count == 8) {
+			gpioBusWrite(&config->__bus, byteValue);
+		} else {
+			gpioBusWrite(&config->__bus, byteValue >> 4);
+			
+			if (interface->__controllerLinkConfigured) {
+				gpioBusStrobe(&config->__bus);
+				gpioBusWrite(&config->__bus, byteValue & 0x0f);
+			}
+		}
+		
+		gpioBusStrobe(&config->__bus);
 	} else {
-		gpioWrite(&config->dataBus, byteValue >> 4);
-
-		if (interface->__controllerLinkConfigured) {
-			gpioWrite(&config->enOutput, 0);
-			gpioWrite(&config->enOutput, 1);
-			gpioWrite(&config->dataBus, byteValue & 0x0f);
-        }
+		gpioWrite(&config->enOutput, 1);
+		
+		if (config->dataBus.count == 8) {
+			gpioWrite(&config->dataBus, byteValue);
+		} else {
+			gpioWrite(&config->dataBus, byteValue >> 4);
+			
+			if (interface->__controllerLinkConfigured) {
+				gpioWrite(&config->enOutput, 0);
+				gpioWrite(&config->enOutput, 1);
+				gpioWrite(&config->dataBus, byteValue & 0x0f);
+			}
+		}
+		
+		gpioWrite(&config->enOutput, 0);
 	}
-
-	gpioWrite(&config->enOutput, 0);
 }
 
 uint8_t lcdLinkDataIn(LCDInterface *interface, LCDDataType dataType) {
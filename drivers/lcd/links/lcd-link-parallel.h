@@ -43,6 +43,7 @@ typedef struct {
 	GpioConfig enOutput;
 	GpioConfig rwOutput;
 	GpioConfig rsOutput;
+	GpioBus __bus; /*!< Data bus and E line, set by lcdLinkInitialise(). */
 } LCDParallelLinkConfig;
 
 #endif // _LCD_LINK_PARALLEL_H
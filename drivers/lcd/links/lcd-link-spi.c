@@ -76,13 +76,7 @@ void lcdLinkDataOut(LCDInterface *interface, LCDDataType dataType, uint8_t byteV
 	
 	gpioWrite(&config->commandDataOutput, dataType);
 	gpioWrite(&config->csOutput, 0);
-	
-	volatile bool readyFlag = false;
-	
-	spiSend(&byteValue, 1, &readyFlag);
-	
-	while (!readyFlag);
-	
+	spiTransferPolled(&byteValue, NULL, 1);
 	gpioWrite(&config->csOutput, 1);
 }
 
@@ -98,3 +98,242 @@ bool fifoRead(FifoState *buffer, void *data, uint8_t count) {
 	
 	return rc;
 }
+
+uint8_t fifoReserve(FifoState *fifo, uint8_t **data) {
+	uint8_t rIndex = fifo->rIndex;
+	uint8_t wIndex = fifo->wIndex;
+	uint8_t count;
+	
+	if (rIndex > wIndex) {
+		count = rIndex - wIndex - 1;
+	} else {
+		// Free space extends up to the end of the buffer, except for
+		// the unused byte that must stay in front of rIndex.
+		count = fifo->size - wIndex;
+		
+		if (rIndex) {
+			count++;
+		}
+	}
+	
+	*data = fifo->data + wIndex;
+	
+	return count;
+}
+
+void fifoCommit(FifoState *fifo, uint8_t count) {
+	// A reserved span never crosses the end of the buffer.
+	uint8_t wIndex = fifo->wIndex + count;
+	
+	if (wIndex > fifo->size) {
+		wIndex = 0;
+	}
+	
+	fifo->wIndex = wIndex;
+}
+
+uint8_t fifoPeekContiguous(FifoState *fifo, uint8_t **data) {
+	uint8_t rIndex = fifo->rIndex;
+	uint8_t wIndex = fifo->wIndex;
+	
+	*data = fifo->data + rIndex;
+	
+	return (wIndex >= rIndex)
+		? (wIndex - rIndex)
+		: (fifo->size - rIndex + 1);
+}
+
+void fifoConsume(FifoState *fifo, uint8_t count) {
+	// A peeked span never crosses the end of the buffer.
+	uint8_t rIndex = fifo->rIndex + count;
+	
+	if (rIndex > fifo->size) {
+		rIndex = 0;
+	}
+	
+	fifo->rIndex = rIndex;
+}
+
+static uint16_t __fifo16Length(FifoState16 *fifo, uint16_t rIndex, uint16_t wIndex) {
+	return (wIndex >= rIndex)
+		? (wIndex - rIndex)
+		: (fifo->size - rIndex + wIndex + 1);
+}
+
+uint16_t fifo16Length(FifoState16 *fifo) {
+	uint16_t rIndex;
+	uint16_t wIndex;
+	
+	CRITICAL {
+		rIndex = fifo->rIndex;
+		wIndex = fifo->wIndex;
+	}
+	
+	return __fifo16Length(fifo, rIndex, wIndex);
+}
+
+void fifo16Clear(FifoState16 *fifo) {
+	CRITICAL {
+		fifo->rIndex = 0;
+		fifo->wIndex = 0;
+	}
+	
+	fifo->status = 0;
+}
+
+bool fifo16IsFull(FifoState16 *fifo) {
+	return fifo16Length(fifo) == fifo->size;
+}
+
+uint16_t fifo16BytesFree(FifoState16 *fifo) {
+	return fifo->size - fifo16Length(fifo);
+}
+
+bool fifo16Write(FifoState16 *fifo, const void *data, uint16_t count) {
+	bool rc = fifo16BytesFree(fifo) >= count;
+	
+	if (rc) {
+		// Only the producer updates wIndex, no need to protect this read.
+		uint16_t wIndex = fifo->wIndex;
+		
+		for (uint16_t n = 0; n < count; n++) {
+			fifo->data[wIndex] = ((const uint8_t *) data)[n];
+			wIndex++;
+			
+			if (wIndex > fifo->size) {
+				wIndex = 0;
+			}
+		}
+		
+		CRITICAL {
+			fifo->wIndex = wIndex;
+		}
+	}
+	
+	return rc;
+}
+
+bool fifo16Read(FifoState16 *fifo, void *data, uint16_t count) {
+	bool rc = fifo16Length(fifo) >= count;
+	
+	if (rc) {
+		// Only the consumer updates rIndex, no need to protect this read.
+		uint16_t rIndex = fifo->rIndex;
+		
+		for (uint16_t n = 0; n < count; n++) {
+			((uint8_t *) data)[n] = fifo->data[rIndex];
+			rIndex++;
+			
+			if (rIndex > fifo->size) {
+				rIndex = 0;
+			}
+		}
+		
+		CRITICAL {
+			fifo->rIndex = rIndex;
+		}
+	}
+	
+	return rc;
+}
+
+uint16_t fifo16Reserve(FifoState16 *fifo, uint8_t **data) {
+	uint16_t wIndex = fifo->wIndex;
+	uint16_t rIndex;
+	uint16_t count;
+	
+	CRITICAL {
+		rIndex = fifo->rIndex;
+	}
+	
+	if (rIndex > wIndex) {
+		count = rIndex - wIndex - 1;
+	} else {
+		count = fifo->size - wIndex;
+		
+		if (rIndex) {
+			count++;
+		}
+	}
+	
+	*data = fifo->data + wIndex;
+	
+	return count;
+}
+
+void fifo16Commit(FifoState16 *fifo, uint16_t count) {
+	uint16_t wIndex = fifo->wIndex + count;
+	
+	if (wIndex > fifo->size) {
+		wIndex = 0;
+	}
+	
+	CRITICAL {
+		fifo->wIndex = wIndex;
+	}
+}
+
+uint16_t fifo16PeekContiguous(FifoState16 *fifo, uint8_t **data) {
+	uint16_t rIndex = fifo->rIndex;
+	uint16_t wIndex;
+	
+	CRITICAL {
+		wIndex = fifo->wIndex;
+	}
+	
+	*data = fifo->data + rIndex;
+	
+	return (wIndex >= rIndex)
+		? (wIndex - rIndex)
+		: (fifo->size - rIndex + 1);
+}
+
+void fifo16Consume(FifoState16 *fifo, uint16_t count) {
+	uint16_t rIndex = fifo->rIndex + count;
+	
+	if (rIndex > fifo->size) {
+		rIndex = 0;
+	}
+	
+	CRITICAL {
+		fifo->rIndex = rIndex;
+	}
+}
+
+void fifoPow2Clear(FifoPow2State *fifo) {
+	fifo->rIndex = 0;
+	fifo->wIndex = 0;
+	fifo->status = 0;
+}
+
+bool fifoPow2Write(FifoPow2State *fifo, const void *data, uint8_t count) {
+	uint8_t wIndex = fifo->wIndex;
+	bool rc = fifoPow2BytesFree(fifo) >= count;
+	
+	if (rc) {
+		for (uint8_t n = 0; n < count; n++) {
+			fifo->data[wIndex & fifo->mask] = ((const uint8_t *) data)[n];
+			wIndex++;
+		}
+		
+		fifo->wIndex = wIndex;
+	}
+	
+	return rc;
+}
+
+bool fifoPow2Read(FifoPow2State *fifo, void *data, uint8_t count) {
+	uint8_t rIndex = fifo->rIndex;
+	bool rc = fifoPow2Length(fifo) >= count;
+	
+	if (rc) {
+		for (uint8_t n = 0; n < count; n++) {
+			((uint8_t *) data)[n] = fifo->data[rIndex & fifo->mask];
+			rIndex++;
+		}
+		
+		fifo->rIndex = rIndex;
+	}
+	
+	return rc;
+}
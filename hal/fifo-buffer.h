@@ -98,4 +98,169 @@ INLINE bool fifoIsEmpty(FifoState *fifo) {
 	return fifoLength(fifo) == 0;
 }
 
+/**
+ * Zero-copy access: fifoReserve() sets *data to the next write position
+ * and returns the number of bytes that can be written there in one go,
+ * i.e. the largest contiguous free span (which may be less than
+ * fifoBytesFree() when the free space wraps around the end of the
+ * buffer). The producer then fills the span in place and publishes
+ * the bytes it has written with fifoCommit().
+ * 
+ * fifoPeekContiguous() and fifoConsume() are their counterparts for
+ * the consumer.
+ * 
+ * The interrupt-safety rules of fifoWrite() and fifoRead() apply:
+ * only the producer may call fifoReserve()/fifoCommit(), and only the
+ * consumer fifoPeekContiguous()/fifoConsume(). count MUST NOT exceed
+ * the value returned by the matching call.
+ */
+uint8_t fifoReserve(FifoState *fifo, uint8_t **data);
+void fifoCommit(FifoState *fifo, uint8_t count);
+
+uint8_t fifoPeekContiguous(FifoState *fifo, uint8_t **data);
+void fifoConsume(FifoState *fifo, uint8_t count);
+
+/**
+ * FIFO circular buffer with 16-bit indexes, for buffers larger than
+ * 255 bytes. Its API mirrors FifoState's.
+ * 
+ * The 8051 can't read or write a 16-bit index atomically, so indexes
+ * are accessed with interrupts disabled. This is short, but it makes
+ * this variant slower than FifoState, which should be preferred for
+ * buffers up to 255 bytes.
+ */
+typedef struct {
+	uint16_t size; /*!< Usable size of the buffer. */
+	uint16_t rIndex; /*!< Index of the next read. */
+	uint16_t wIndex; /*!< Index of the next write. */
+	uint8_t status; /*!< Application-defined status byte. */
+	uint8_t *data; /*!< Buffer address (must be statically allocated). */
+} FifoState16;
+
+/**
+ * Declares a FifoState16 variable and its buffer.
+ * bufferSize is the usable size of the buffer and MUST be in [1; 65534].
+ * Effective buffer size is bufferSize + 1, as for FIFO_BUFFER.
+ */
+#define FIFO_BUFFER16(variableName, bufferSize, segment) \
+	static uint8_t segment variableName ## Data[bufferSize + 1]; \
+	FifoState16 segment variableName = { \
+		.size = bufferSize, \
+		.rIndex = 0, \
+		.wIndex = 0, \
+		.status = 0, \
+		.data = variableName ## Data, \
+	};
+
+uint16_t fifo16Length(FifoState16 *fifo);
+void fifo16Clear(FifoState16 *fifo);
+
+bool fifo16Write(FifoState16 *fifo, const void *data, uint16_t count);
+bool fifo16Read(FifoState16 *fifo, void *data, uint16_t count);
+
+bool fifo16IsFull(FifoState16 *fifo);
+uint16_t fifo16BytesFree(FifoState16 *fifo);
+
+#define fifo16BytesUsed(fifo) fifo16Length(fifo)
+
+INLINE bool fifo16IsEmpty(FifoState16 *fifo) {
+	return fifo16Length(fifo) == 0;
+}
+
+uint16_t fifo16Reserve(FifoState16 *fifo, uint8_t **data);
+void fifo16Commit(FifoState16 *fifo, uint16_t count);
+
+uint16_t fifo16PeekContiguous(FifoState16 *fifo, uint8_t **data);
+void fifo16Consume(FifoState16 *fifo, uint16_t count);
+
+/**
+ * Power-of-two FIFO circular buffer.
+ * 
+ * rIndex and wIndex are free-running counters that are only masked
+ * when accessing data[], so the number of bytes in use is simply
+ * wIndex - rIndex (modulo 256), without any branch, and the whole
+ * buffer is usable.
+ * 
+ * Like FifoState, it is interrupt-safe without masking interrupts as
+ * long as there's a single producer and a single consumer (e.g. ISR
+ * writes, main loop reads): each side only ever updates its own index,
+ * and does so with a single byte store once data has been copied.
+ */
+typedef struct {
+	uint8_t mask; /*!< Buffer size - 1. */
+	volatile uint8_t rIndex; /*!< Free-running read counter. */
+	volatile uint8_t wIndex; /*!< Free-running write counter. */
+	uint8_t status; /*!< Application-defined status byte. */
+	uint8_t *data; /*!< Buffer address (must be statically allocated). */
+} FifoPow2State;
+
+/**
+ * Declares a FifoPow2State variable and its buffer.
+ * bufferSize MUST be a power of 2 in [2; 128], and is both the usable
+ * and the effective size of the buffer. Other sizes are rejected at
+ * compile time (negative array size error on variableNameSizeCheck).
+ */
+#define FIFO_BUFFER_POW2(variableName, bufferSize, segment) \
+	typedef char variableName ## SizeCheck[ \
+		((bufferSize) < 2 || (bufferSize) > 128 || ((bufferSize) & ((bufferSize) - 1))) ? -1 : 1]; \
+	static uint8_t segment variableName ## Data[bufferSize]; \
+	FifoPow2State segment variableName = { \
+		.mask = (bufferSize) - 1, \
+		.rIndex = 0, \
+		.wIndex = 0, \
+		.status = 0, \
+		.data = variableName ## Data, \
+	};
+
+void fifoPow2Clear(FifoPow2State *fifo);
+
+bool fifoPow2Write(FifoPow2State *fifo, const void *data, uint8_t count);
+bool fifoPow2Read(FifoPow2State *fifo, void *data, uint8_t count);
+
+INLINE uint8_t fifoPow2Length(FifoPow2State *fifo) {
+	return (uint8_t) (fifo->wIndex - fifo->rIndex);
+}
+
+INLINE uint8_t fifoPow2BytesFree(FifoPow2State *fifo) {
+	return (uint8_t) (fifo->mask + 1 - fifoPow2Length(fifo));
+}
+
+INLINE bool fifoPow2IsEmpty(FifoPow2State *fifo) {
+	return fifo->wIndex == fifo->rIndex;
+}
+
+INLINE bool fifoPow2IsFull(FifoPow2State *fifo) {
+	return fifoPow2Length(fifo) > fifo->mask;
+}
+
+/**
+ * Single-byte write, intended for ISR. Returns false when full.
+ */
+INLINE bool fifoPow2WriteByte(FifoPow2State *fifo, uint8_t byte) {
+	uint8_t wIndex = fifo->wIndex;
+	bool rc = (uint8_t) (wIndex - fifo->rIndex) <= fifo->mask;
+	
+	if (rc) {
+		fifo->data[wIndex & fifo->mask] = byte;
+		fifo->wIndex = wIndex + 1;
+	}
+	
+	return rc;
+}
+
+/**
+ * Single-byte read, intended for ISR. Returns false when empty.
+ */
+INLINE bool fifoPow2ReadByte(FifoPow2State *fifo, uint8_t *byte) {
+	uint8_t rIndex = fifo->rIndex;
+	bool rc = fifo->wIndex != rIndex;
+	
+	if (rc) {
+		*byte = fifo->data[rIndex & fifo->mask];
+		fifo->rIndex = rIndex + 1;
+	}
+	
+	return rc;
+}
+
 #endif // _FIFO_BUFFER_H
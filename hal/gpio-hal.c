@@ -36,20 +36,19 @@
  * GPIO abstraction layer implementation.
  */
 
-static uint8_t __gpio_setBits(uint8_t portValue, uint8_t cfgValue, GpioConfig *gpioConfig) {
-	return cfgValue ? (portValue | gpioConfig->__setMask) : (portValue & gpioConfig->__clearMask);
+static uint8_t __gpio_setBits(uint8_t portValue, uint8_t cfgValue, uint8_t setMask) {
+	return cfgValue ? (portValue | setMask) : (portValue & ~setMask);
 }
 
-static uint8_t __isOutput(GpioConfig *gpioConfig) {
+static uint8_t __isOutput(const GpioConfig *gpioConfig) {
 	return gpioConfig->pinMode == GPIO_BIDIRECTIONAL_MODE || gpioConfig->pinMode == GPIO_PUSH_PULL_MODE || gpioConfig->pinMode == GPIO_OPEN_DRAIN_MODE;
 }
 
-static uint8_t __isInput(GpioConfig *gpioConfig) {
+static uint8_t __isInput(const GpioConfig *gpioConfig) {
 	return gpioConfig->pinMode == GPIO_BIDIRECTIONAL_MODE || gpioConfig->pinMode == GPIO_HIGH_IMPEDANCE_MODE;
 }
 
-void gpioConfigure(GpioConfig *gpioConfig) {
-	// Pre-generate bit masks for read/write operations
+static uint8_t __gpio_setMask(const GpioConfig *gpioConfig) {
 	uint8_t mask = 0;
 	
 	for (uint8_t n = gpioConfig->count; n > 0; n--) {
@@ -57,56 +56,60 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 		mask |= 1;
 	}
 	
-	gpioConfig->__setMask = mask << gpioConfig->pin;
-	gpioConfig->__clearMask = ~gpioConfig->__setMask;
-	
-	uint8_t pm1 = 0;
-	uint8_t pm0 = 0;
+	return mask << gpioConfig->pin;
+}
 
+// Configuration registers of a port.
+typedef struct {
+	uint8_t pm1;
+	uint8_t pm0;
+	
 #ifdef GPIO_HAS_PU_NCS
-	uint8_t pncs = 0;
-	uint8_t ppu = 0;
+	uint8_t pncs;
+	uint8_t ppu;
 #endif // GPIO_HAS_PU_NCS
-		
+	
 #ifdef GPIO_HAS_SR_DR_IE
-	uint8_t pdr = 0;
-	uint8_t psr = 0;
-	uint8_t pie = 0;
+	uint8_t pdr;
+	uint8_t psr;
+	uint8_t pie;
 #endif // GPIO_HAS_SR_DR_IE
-		
+	
 #ifdef GPIO_HAS_INT_WK
-	uint8_t pim1 = 0;
-	uint8_t pim0 = 0;
-	uint8_t pintf = 0;
-	uint8_t pinte = 0;
-	uint8_t pwkue = 0;
+	uint8_t pim1;
+	uint8_t pim0;
+	uint8_t pintf;
+	uint8_t pinte;
+	uint8_t pwkue;
 #endif // GPIO_HAS_INT_WK
-	
-	switch (gpioConfig->port) {
+} GpioPortRegisters;
+
+static void __gpio_readRegisters(GpioPort port, GpioPortRegisters *registers) {
+	switch (port) {
 // -- P0 ----------------------------------
 
 #ifdef GPIO_HAS_P0
 	case GPIO_PORT0:
-		pm1 = P0M1;
-		pm0 = P0M0;
+		registers->pm1 = P0M1;
+		registers->pm0 = P0M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P0NCS;
-		ppu = P0PU;
+		registers->pncs = P0NCS;
+		registers->ppu = P0PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P0DR;
-		psr = P0SR;
-		pie = P0IE;
+		registers->pdr = P0DR;
+		registers->psr = P0SR;
+		registers->pie = P0IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P0IM1;
-		pim0 = P0IM0;
-		pintf = P0INTF;
-		pinte = P0INTE;
-		pwkue = P0WKUE;
+		registers->pim1 = P0IM1;
+		registers->pim0 = P0IM0;
+		registers->pintf = P0INTF;
+		registers->pinte = P0INTE;
+		registers->pwkue = P0WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P0
@@ -115,26 +118,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P1
 	case GPIO_PORT1:
-		pm1 = P1M1;
-		pm0 = P1M0;
+		registers->pm1 = P1M1;
+		registers->pm0 = P1M0;
 
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P1NCS;
-		ppu = P1PU;
+		registers->pncs = P1NCS;
+		registers->ppu = P1PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P1DR;
-		psr = P1SR;
-		pie = P1IE;
+		registers->pdr = P1DR;
+		registers->psr = P1SR;
+		registers->pie = P1IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P1IM1;
-		pim0 = P1IM0;
-		pintf = P1INTF;
-		pinte = P1INTE;
-		pwkue = P1WKUE;
+		registers->pim1 = P1IM1;
+		registers->pim0 = P1IM0;
+		registers->pintf = P1INTF;
+		registers->pinte = P1INTE;
+		registers->pwkue = P1WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P1
@@ -143,26 +146,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P2
 	case GPIO_PORT2:
-		pm1 = P2M1;
-		pm0 = P2M0;
+		registers->pm1 = P2M1;
+		registers->pm0 = P2M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P2NCS;
-		ppu = P2PU;
+		registers->pncs = P2NCS;
+		registers->ppu = P2PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P2DR;
-		psr = P2SR;
-		pie = P2IE;
+		registers->pdr = P2DR;
+		registers->psr = P2SR;
+		registers->pie = P2IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P2IM1;
-		pim0 = P2IM0;
-		pintf = P2INTF;
-		pinte = P2INTE;
-		pwkue = P2WKUE;
+		registers->pim1 = P2IM1;
+		registers->pim0 = P2IM0;
+		registers->pintf = P2INTF;
+		registers->pinte = P2INTE;
+		registers->pwkue = P2WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P2
@@ -170,26 +173,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 // -- P3 ----------------------------------
 
 	case GPIO_PORT3:
-		pm1 = P3M1;
-		pm0 = P3M0;
+		registers->pm1 = P3M1;
+		registers->pm0 = P3M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P3NCS;
-		ppu = P3PU;
+		registers->pncs = P3NCS;
+		registers->ppu = P3PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P3DR;
-		psr = P3SR;
-		pie = P3IE;
+		registers->pdr = P3DR;
+		registers->psr = P3SR;
+		registers->pie = P3IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P3IM1;
-		pim0 = P3IM0;
-		pintf = P3INTF;
-		pinte = P3INTE;
-		pwkue = P3WKUE;
+		registers->pim1 = P3IM1;
+		registers->pim0 = P3IM0;
+		registers->pintf = P3INTF;
+		registers->pinte = P3INTE;
+		registers->pwkue = P3WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 
@@ -197,26 +200,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P4
 	case GPIO_PORT4:
-		pm1 = P4M1;
-		pm0 = P4M0;
+		registers->pm1 = P4M1;
+		registers->pm0 = P4M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P4NCS;
-		ppu = P4PU;
+		registers->pncs = P4NCS;
+		registers->ppu = P4PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P4DR;
-		psr = P4SR;
-		pie = P4IE;
+		registers->pdr = P4DR;
+		registers->psr = P4SR;
+		registers->pie = P4IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P4IM1;
-		pim0 = P4IM0;
-		pintf = P4INTF;
-		pinte = P4INTE;
-		pwkue = P4WKUE;
+		registers->pim1 = P4IM1;
+		registers->pim0 = P4IM0;
+		registers->pintf = P4INTF;
+		registers->pinte = P4INTE;
+		registers->pwkue = P4WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P4
@@ -225,26 +228,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P5
 	case GPIO_PORT5:
-		pm1 = P5M1;
-		pm0 = P5M0;
+		registers->pm1 = P5M1;
+		registers->pm0 = P5M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P5NCS;
-		ppu = P5PU;
+		registers->pncs = P5NCS;
+		registers->ppu = P5PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P5DR;
-		psr = P5SR;
-		pie = P5IE;
+		registers->pdr = P5DR;
+		registers->psr = P5SR;
+		registers->pie = P5IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P5IM1;
-		pim0 = P5IM0;
-		pintf = P5INTF;
-		pinte = P5INTE;
-		pwkue = P5WKUE;
+		registers->pim1 = P5IM1;
+		registers->pim0 = P5IM0;
+		registers->pintf = P5INTF;
+		registers->pinte = P5INTE;
+		registers->pwkue = P5WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P5
@@ -253,26 +256,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P6
 	case GPIO_PORT6:
-		pm1 = P6M1;
-		pm0 = P6M0;
+		registers->pm1 = P6M1;
+		registers->pm0 = P6M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P6NCS;
-		ppu = P6PU;
+		registers->pncs = P6NCS;
+		registers->ppu = P6PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P6DR;
-		psr = P6SR;
-		pie = P6IE;
+		registers->pdr = P6DR;
+		registers->psr = P6SR;
+		registers->pie = P6IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P6IM1;
-		pim0 = P6IM0;
-		pintf = P6INTF;
-		pinte = P6INTE;
-		pwkue = P6WKUE;
+		registers->pim1 = P6IM1;
+		registers->pim0 = P6IM0;
+		registers->pintf = P6INTF;
+		registers->pinte = P6INTE;
+		registers->pwkue = P6WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P6
@@ -281,83 +284,87 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P7
 	case GPIO_PORT7:
-		pm1 = P7M1;
-		pm0 = P7M0;
+		registers->pm1 = P7M1;
+		registers->pm0 = P7M0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		pncs = P7NCS;
-		ppu = P7PU;
+		registers->pncs = P7NCS;
+		registers->ppu = P7PU;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		pdr = P7DR;
-		psr = P7SR;
-		pie = P7IE;
+		registers->pdr = P7DR;
+		registers->psr = P7SR;
+		registers->pie = P7IE;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		pim1 = P7IM1;
-		pim0 = P7IM0;
-		pintf = P7INTF;
-		pinte = P7INTE;
-		pwkue = P7WKUE;
+		registers->pim1 = P7IM1;
+		registers->pim0 = P7IM0;
+		registers->pintf = P7INTF;
+		registers->pinte = P7INTE;
+		registers->pwkue = P7WKUE;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P7
 	}
-	
-	pm1 = __gpio_setBits(pm1, gpioConfig->pinMode & 2, gpioConfig);
-	pm0 = __gpio_setBits(pm0, gpioConfig->pinMode & 1, gpioConfig);
+}
+
+static void __gpio_applyConfig(GpioPortRegisters *registers, const GpioConfig *gpioConfig, uint8_t setMask) {
+	registers->pm1 = __gpio_setBits(registers->pm1, gpioConfig->pinMode & 2, setMask);
+	registers->pm0 = __gpio_setBits(registers->pm0, gpioConfig->pinMode & 1, setMask);
 	
 #ifdef GPIO_HAS_PU_NCS
-	pncs = __gpio_setBits(pncs, gpioConfig->schmidtTrigger, gpioConfig);
-	ppu = __gpio_setBits(ppu, gpioConfig->internalPullUp, gpioConfig);
+	registers->pncs = __gpio_setBits(registers->pncs, gpioConfig->schmidtTrigger, setMask);
+	registers->ppu = __gpio_setBits(registers->ppu, gpioConfig->internalPullUp, setMask);
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
 	if (__isOutput(gpioConfig)) {
-		pdr = __gpio_setBits(pdr, gpioConfig->speed & 1, gpioConfig);
-		psr = __gpio_setBits(psr, gpioConfig->speed & 2, gpioConfig);
+		registers->pdr = __gpio_setBits(registers->pdr, gpioConfig->speed & 1, setMask);
+		registers->psr = __gpio_setBits(registers->psr, gpioConfig->speed & 2, setMask);
 	}
 	
 	if (__isInput(gpioConfig)) {
-		pie = __gpio_setBits(pie, gpioConfig->digitalInput, gpioConfig);
+		registers->pie = __gpio_setBits(registers->pie, gpioConfig->digitalInput, setMask);
 	}
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-	pim1 = __gpio_setBits(pim1, gpioConfig->interruptTrigger & 2, gpioConfig);
-	pim0 = __gpio_setBits(pim0, gpioConfig->interruptTrigger & 1, gpioConfig);
-	pintf &= gpioConfig->__clearMask;
-	pinte = __gpio_setBits(pinte, gpioConfig->pinInterrupt, gpioConfig);
-	pwkue = __gpio_setBits(pwkue, gpioConfig->wakeUpInterrupt, gpioConfig);
+	registers->pim1 = __gpio_setBits(registers->pim1, gpioConfig->interruptTrigger & 2, setMask);
+	registers->pim0 = __gpio_setBits(registers->pim0, gpioConfig->interruptTrigger & 1, setMask);
+	registers->pintf &= ~setMask;
+	registers->pinte = __gpio_setBits(registers->pinte, gpioConfig->pinInterrupt, setMask);
+	registers->pwkue = __gpio_setBits(registers->pwkue, gpioConfig->wakeUpInterrupt, setMask);
 #endif // GPIO_HAS_INT_WK
-	
-	switch (gpioConfig->port) {
+}
+
+static void __gpio_writeRegisters(GpioPort port, GpioPortRegisters *registers) {
+	switch (port) {
 // -- P0 ----------------------------------
 
 #ifdef GPIO_HAS_P0
 	case GPIO_PORT0:
-		P0M1 = pm1;
-		P0M0 = pm0;
+		P0M1 = registers->pm1;
+		P0M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P0NCS = pncs;
-		P0PU = ppu;
+		P0NCS = registers->pncs;
+		P0PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P0DR = pdr;
-		P0SR = psr;
-		P0IE = pie;
+		P0DR = registers->pdr;
+		P0SR = registers->psr;
+		P0IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P0IM1 = pim1;
-		P0IM0 = pim0;
-		P0INTF = pintf;
-		P0INTE = pinte;
-		P0WKUE = pwkue;
+		P0IM1 = registers->pim1;
+		P0IM0 = registers->pim0;
+		P0INTF = registers->pintf;
+		P0INTE = registers->pinte;
+		P0WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P0
@@ -366,26 +373,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P1
 	case GPIO_PORT1:
-		P1M1 = pm1;
-		P1M0 = pm0;
+		P1M1 = registers->pm1;
+		P1M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P1NCS = pncs;
-		P1PU = ppu;
+		P1NCS = registers->pncs;
+		P1PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P1DR = pdr;
-		P1SR = psr;
-		P1IE = pie;
+		P1DR = registers->pdr;
+		P1SR = registers->psr;
+		P1IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P1IM1 = pim1;
-		P1IM0 = pim0;
-		P1INTF = pintf;
-		P1INTE = pinte;
-		P1WKUE = pwkue;
+		P1IM1 = registers->pim1;
+		P1IM0 = registers->pim0;
+		P1INTF = registers->pintf;
+		P1INTE = registers->pinte;
+		P1WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P1
@@ -394,26 +401,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P2
 	case GPIO_PORT2:
-		P2M1 = pm1;
-		P2M0 = pm0;
+		P2M1 = registers->pm1;
+		P2M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P2NCS = pncs;
-		P2PU = ppu;
+		P2NCS = registers->pncs;
+		P2PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P2DR = pdr;
-		P2SR = psr;
-		P2IE = pie;
+		P2DR = registers->pdr;
+		P2SR = registers->psr;
+		P2IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P2IM1 = pim1;
-		P2IM0 = pim0;
-		P2INTF = pintf;
-		P2INTE = pinte;
-		P2WKUE = pwkue;
+		P2IM1 = registers->pim1;
+		P2IM0 = registers->pim0;
+		P2INTF = registers->pintf;
+		P2INTE = registers->pinte;
+		P2WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P2
@@ -421,26 +428,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 // -- P3 ----------------------------------
 
 	case GPIO_PORT3:
-		P3M1 = pm1;
-		P3M0 = pm0;
+		P3M1 = registers->pm1;
+		P3M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P3NCS = pncs;
-		P3PU = ppu;
+		P3NCS = registers->pncs;
+		P3PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P3DR = pdr;
-		P3SR = psr;
-		P3IE = pie;
+		P3DR = registers->pdr;
+		P3SR = registers->psr;
+		P3IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P3IM1 = pim1;
-		P3IM0 = pim0;
-		P3INTF = pintf;
-		P3INTE = pinte;
-		P3WKUE = pwkue;
+		P3IM1 = registers->pim1;
+		P3IM0 = registers->pim0;
+		P3INTF = registers->pintf;
+		P3INTE = registers->pinte;
+		P3WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 
@@ -448,26 +455,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P4
 	case GPIO_PORT4:
-		P4M1 = pm1;
-		P4M0 = pm0;
+		P4M1 = registers->pm1;
+		P4M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P4NCS = pncs;
-		P4PU = ppu;
+		P4NCS = registers->pncs;
+		P4PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P4DR = pdr;
-		P4SR = psr;
-		P4IE = pie;
+		P4DR = registers->pdr;
+		P4SR = registers->psr;
+		P4IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P4IM1 = pim1;
-		P4IM0 = pim0;
-		P4INTF = pintf;
-		P4INTE = pinte;
-		P4WKUE = pwkue;
+		P4IM1 = registers->pim1;
+		P4IM0 = registers->pim0;
+		P4INTF = registers->pintf;
+		P4INTE = registers->pinte;
+		P4WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P4
@@ -476,26 +483,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P5
 	case GPIO_PORT5:
-		P5M1 = pm1;
-		P5M0 = pm0;
+		P5M1 = registers->pm1;
+		P5M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P5NCS = pncs;
-		P5PU = ppu;
+		P5NCS = registers->pncs;
+		P5PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P5DR = pdr;
-		P5SR = psr;
-		P5IE = pie;
+		P5DR = registers->pdr;
+		P5SR = registers->psr;
+		P5IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P5IM1 = pim1;
-		P5IM0 = pim0;
-		P5INTF = pintf;
-		P5INTE = pinte;
-		P5WKUE = pwkue;
+		P5IM1 = registers->pim1;
+		P5IM0 = registers->pim0;
+		P5INTF = registers->pintf;
+		P5INTE = registers->pinte;
+		P5WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P5
@@ -504,26 +511,26 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P6
 	case GPIO_PORT6:
-		P6M1 = pm1;
-		P6M0 = pm0;
+		P6M1 = registers->pm1;
+		P6M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P6NCS = pncs;
-		P6PU = ppu;
+		P6NCS = registers->pncs;
+		P6PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P6DR = pdr;
-		P6SR = psr;
-		P6IE = pie;
+		P6DR = registers->pdr;
+		P6SR = registers->psr;
+		P6IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P6IM1 = pim1;
-		P6IM0 = pim0;
-		P6INTF = pintf;
-		P6INTE = pinte;
-		P6WKUE = pwkue;
+		P6IM1 = registers->pim1;
+		P6IM0 = registers->pim0;
+		P6INTF = registers->pintf;
+		P6INTE = registers->pinte;
+		P6WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P6
@@ -532,32 +539,66 @@ void gpioConfigure(GpioConfig *gpioConfig) {
 
 #ifdef GPIO_HAS_P7
 	case GPIO_PORT7:
-		P7M1 = pm1;
-		P7M0 = pm0;
+		P7M1 = registers->pm1;
+		P7M0 = registers->pm0;
 	
 #ifdef GPIO_HAS_PU_NCS
-		P7NCS = pncs;
-		P7PU = ppu;
+		P7NCS = registers->pncs;
+		P7PU = registers->ppu;
 #endif // GPIO_HAS_PU_NCS
 		
 #ifdef GPIO_HAS_SR_DR_IE
-		P7DR = pdr;
-		P7SR = psr;
-		P7IE = pie;
+		P7DR = registers->pdr;
+		P7SR = registers->psr;
+		P7IE = registers->pie;
 #endif // GPIO_HAS_SR_DR_IE
 		
 #ifdef GPIO_HAS_INT_WK
-		P7IM1 = pim1;
-		P7IM0 = pim0;
-		P7INTF = pintf;
-		P7INTE = pinte;
-		P7WKUE = pwkue;
+		P7IM1 = registers->pim1;
+		P7IM0 = registers->pim0;
+		P7INTF = registers->pintf;
+		P7INTE = registers->pinte;
+		P7WKUE = registers->pwkue;
 #endif // GPIO_HAS_INT_WK
 		break;
 #endif // GPIO_HAS_P7
 	}
 }
 
+void gpioConfigure(GpioConfig *gpioConfig) {
+	// Pre-generate bit masks for read/write operations
+	gpioConfig->__setMask = __gpio_setMask(gpioConfig);
+	gpioConfig->__clearMask = ~gpioConfig->__setMask;
+	
+	GpioPortRegisters registers;
+	__gpio_readRegisters(gpioConfig->port, &registers);
+	__gpio_applyConfig(&registers, gpioConfig, gpioConfig->__setMask);
+	__gpio_writeRegisters(gpioConfig->port, &registers);
+}
+
+void gpioConfigureTable(const GpioConfig *table, uint8_t count) {
+	GpioPortRegisters registers;
+	
+	for (uint8_t port = 0; port < 8; port++) {
+		bool found = false;
+		
+		for (uint8_t i = 0; i < count; i++) {
+			if (table[i].port == port) {
+				if (!found) {
+					__gpio_readRegisters((GpioPort) port, &registers);
+					found = true;
+				}
+				
+				__gpio_applyConfig(&registers, &table[i], __gpio_setMask(&table[i]));
+			}
+		}
+		
+		if (found) {
+			__gpio_writeRegisters((GpioPort) port, &registers);
+		}
+	}
+}
+
 static uint8_t __getPort(GpioPort port) {
 	uint8_t value = 0;
 	
@@ -692,3 +733,143 @@ void gpioWrite(GpioConfig *gpioConfig, uint8_t value) {
 #endif // GPIO_HAS_P7
 	}
 }
+
+void gpioBusInitialise(GpioBus *bus, const GpioConfig *dataBus, const GpioConfig *strobe) {
+	bus->port = dataBus->port;
+	bus->shift = dataBus->pin;
+	bus->mask = dataBus->__setMask;
+	bus->strobe = (strobe && strobe->port == dataBus->port) ? strobe->__setMask : 0;
+}
+
+// A single read and a single store of the port.
+#define GPIO_BUS_WRITE(n) \
+	case GPIO_PORT ## n: \
+		P ## n = (P ## n & keep) | value; \
+		break;
+
+void gpioBusWrite(const GpioBus *bus, uint8_t value) {
+	uint8_t keep = ~(bus->mask | bus->strobe);
+	value = ((value << bus->shift) & bus->mask) | bus->strobe;
+	
+	switch (bus->port) {
+#ifdef GPIO_HAS_P0
+	GPIO_BUS_WRITE(0)
+#endif // GPIO_HAS_P0
+#ifdef GPIO_HAS_P1
+	GPIO_BUS_WRITE(1)
+#endif // GPIO_HAS_P1
+#ifdef GPIO_HAS_P2
+	GPIO_BUS_WRITE(2)
+#endif // GPIO_HAS_P2
+	GPIO_BUS_WRITE(3)
+#ifdef GPIO_HAS_P4
+	GPIO_BUS_WRITE(4)
+#endif // GPIO_HAS_P4
+#ifdef GPIO_HAS_P5
+	GPIO_BUS_WRITE(5)
+#endif // GPIO_HAS_P5
+#ifdef GPIO_HAS_P6
+	GPIO_BUS_WRITE(6)
+#endif // GPIO_HAS_P6
+#ifdef GPIO_HAS_P7
+	GPIO_BUS_WRITE(7)
+#endif // GPIO_HAS_P7
+	}
+}
+
+#define GPIO_BUS_STROBE(n) \
+	case GPIO_PORT ## n: \
+		P ## n &= keep; \
+		break;
+
+void gpioBusStrobe(const GpioBus *bus) {
+	uint8_t keep = ~bus->strobe;
+	
+	switch (bus->port) {
+#ifdef GPIO_HAS_P0
+	GPIO_BUS_STROBE(0)
+#endif // GPIO_HAS_P0
+#ifdef GPIO_HAS_P1
+	GPIO_BUS_STROBE(1)
+#endif // GPIO_HAS_P1
+#ifdef GPIO_HAS_P2
+	GPIO_BUS_STROBE(2)
+#endif // GPIO_HAS_P2
+	GPIO_BUS_STROBE(3)
+#ifdef GPIO_HAS_P4
+	GPIO_BUS_STROBE(4)
+#endif // GPIO_HAS_P4
+#ifdef GPIO_HAS_P5
+	GPIO_BUS_STROBE(5)
+#endif // GPIO_HAS_P5
+#ifdef GPIO_HAS_P6
+	GPIO_BUS_STROBE(6)
+#endif // GPIO_HAS_P6
+#ifdef GPIO_HAS_P7
+	GPIO_BUS_STROBE(7)
+#endif // GPIO_HAS_P7
+	}
+}
+
+#ifdef HAL_GPIO_API_INTERRUPT
+	#ifndef GPIO_INTERRUPT_TIMESTAMP
+		#define GPIO_INTERRUPT_TIMESTAMP 0
+	#endif // GPIO_INTERRUPT_TIMESTAMP
+	
+	// Index of the lowest bit set in a nibble (0 has no bit set).
+	static const uint8_t __code __gpioLowestBit[16] = {
+		0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	};
+	
+	static void __gpioDispatch(GpioPort port, uint8_t flags, uint16_t timestamp) {
+		while (flags) {
+			uint8_t pin = (flags & 0x0f)
+				? __gpioLowestBit[flags & 0x0f]
+				: 4 + __gpioLowestBit[flags >> 4];
+			// Clear the lowest bit set
+			flags &= flags - 1;
+			GpioPinHandler handler = gpioPinHandlers[port][pin];
+			
+			if (handler) {
+				handler(port, (GpioPin) pin, timestamp);
+			}
+		}
+	}
+	
+	/*
+	 * Flags are cleared before calling handlers, so that edges
+	 * occurring in the meantime aren't lost.
+	 */
+	#define GPIO_PORT_ISR(n) \
+		INTERRUPT(gpio_p ## n ## _isr, P ## n ## _INTERRUPT) { \
+			uint16_t timestamp = GPIO_INTERRUPT_TIMESTAMP; \
+			uint8_t flags = P ## n ## INTF; \
+			P ## n ## INTF &= ~flags; \
+			__gpioDispatch(GPIO_PORT ## n, flags, timestamp); \
+		}
+	
+	#if defined(GPIO_HAS_P0) && (GPIO_INTERRUPT_PORTS & 0x01)
+		GPIO_PORT_ISR(0)
+	#endif
+	#if defined(GPIO_HAS_P1) && (GPIO_INTERRUPT_PORTS & 0x02)
+		GPIO_PORT_ISR(1)
+	#endif
+	#if defined(GPIO_HAS_P2) && (GPIO_INTERRUPT_PORTS & 0x04)
+		GPIO_PORT_ISR(2)
+	#endif
+	#if GPIO_INTERRUPT_PORTS & 0x08
+		GPIO_PORT_ISR(3)
+	#endif
+	#if defined(GPIO_HAS_P4) && (GPIO_INTERRUPT_PORTS & 0x10)
+		GPIO_PORT_ISR(4)
+	#endif
+	#if defined(GPIO_HAS_P5) && (GPIO_INTERRUPT_PORTS & 0x20)
+		GPIO_PORT_ISR(5)
+	#endif
+	#if defined(GPIO_HAS_P6) && (GPIO_INTERRUPT_PORTS & 0x40)
+		GPIO_PORT_ISR(6)
+	#endif
+	#if defined(GPIO_HAS_P7) && (GPIO_INTERRUPT_PORTS & 0x80)
+		GPIO_PORT_ISR(7)
+	#endif
+#endif // HAL_GPIO_API_INTERRUPT
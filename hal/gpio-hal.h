@@ -51,6 +51,21 @@
  *     support for enhanced GPIO features available on STC8 MCU series.
  *     Greatly helps reduce flash footprint on STC8, but has no effect
  *     on other MCU series.
+ * 
+ *     HAL_GPIO_API_INTERRUPT (default: undefined, requires
+ *     GPIO_HAS_INT_WK) enables the pin interrupt dispatcher, see
+ *     gpioPinHandlers.
+ * 
+ *     GPIO_INTERRUPT_PORTS (default: 0xff) is the bit mask of the ports
+ *     whose ISR is installed by the pin interrupt dispatcher, bit 0
+ *     standing for P0.
+ * 
+ *     GPIO_INTERRUPT_TIMESTAMP (default: 0) is an expression evaluated
+ *     when a port interrupt occurs, and passed to pin handlers as the
+ *     timestamp of the edge, e.g. the 16-bit counter of a free-running
+ *     timer:
+ * 
+ *         #define GPIO_INTERRUPT_TIMESTAMP T0
  */
 
 #ifdef BASIC_GPIO_HAL
@@ -180,6 +195,18 @@ typedef struct {
  */
 void gpioConfigure(GpioConfig *config);
 
+/**
+ * Configures all pins described by table, e.g. at boot. Entries for
+ * the same port are merged, so that each configuration register of
+ * each port is only read and written once. table may (and should)
+ * be located in __code.
+ * 
+ * Since table isn't modified, gpioRead() and gpioWrite() can't use
+ * its entries: configure pins with gpioConfigure() instead when they
+ * need them, or use static pins.
+ */
+void gpioConfigureTable(const GpioConfig *table, uint8_t count);
+
 /**
  * Reads a GPIO pin, or series of consecutive pins.
  * 
@@ -202,4 +229,140 @@ INLINE void gpioToggle(GpioConfig *config) {
 	gpioWrite(config, !gpioRead(config));
 }
 
+/**
+ * Parallel bus: data pins, plus an optional strobe pin (e.g. the
+ * E line of an HD44780) on the same port, precomputed by
+ * gpioBusInitialise() so that writing to the bus takes a single
+ * read-modify-write of the port.
+ */
+typedef struct {
+	GpioPort port;
+	uint8_t shift; /*!< Index of the pin receiving bit 0 of the value. */
+	uint8_t mask; /*!< Data pins. */
+	uint8_t strobe; /*!< Strobe pin, 0 if none. */
+} GpioBus;
+
+/**
+ * dataBus and strobe MUST have been configured with gpioConfigure().
+ * strobe may be NULL. When it's on another port than dataBus, bus->strobe
+ * is left to 0 and the caller needs to drive it with gpioWrite().
+ */
+void gpioBusInitialise(GpioBus *bus, const GpioConfig *dataBus, const GpioConfig *strobe);
+
+/**
+ * Writes value to the data pins and raises the strobe pin in a single
+ * store. value is shifted and masked as by gpioWrite().
+ */
+void gpioBusWrite(const GpioBus *bus, uint8_t value);
+
+/**
+ * Lowers the strobe pin, e.g. to latch data written by gpioBusWrite().
+ * The call overhead alone keeps the strobe pulse longer than most
+ * devices require (e.g. 230 ns for an HD44780).
+ */
+void gpioBusStrobe(const GpioBus *bus);
+
+/**
+ * Static pins: when a pin is known at compile time, e.g.
+ * 
+ *     #define LED_PIN GPIO_STATIC_PIN(P1, 3)
+ * 
+ * gpioStaticWrite(), gpioStaticRead() and gpioStaticToggle() access it
+ * directly through its sbit, i.e. with a single setb/clr/mov/cpl
+ * instruction instead of a call to gpioWrite() or gpioRead(). The pin
+ * MUST be bit-addressable (P0 to P7 on all supported MCU).
+ * 
+ * Static pins are still configured through a GpioConfig, which
+ * GPIO_STATIC_PIN_CONFIG() initialises from the same port and pin:
+ * 
+ *     GpioConfig ledConfig = GPIO_STATIC_PIN_CONFIG(P1, 3, GPIO_PUSH_PULL_MODE);
+ *     gpioConfigure(&ledConfig);
+ * 
+ * Drivers which need fast pin access may take the name of a static pin
+ * as a configuration macro.
+ */
+#define GPIO_STATIC_PIN(port, pin) port ## _ ## pin
+
+#define GPIO_STATIC_PIN_CONFIG(port, pin, gpioMode) \
+	GPIO_PIN_CONFIG(__GPIO_STATIC_PORT_ ## port, GPIO_PIN ## pin, gpioMode)
+
+#define __GPIO_STATIC_PORT_P0 GPIO_PORT0
+#define __GPIO_STATIC_PORT_P1 GPIO_PORT1
+#define __GPIO_STATIC_PORT_P2 GPIO_PORT2
+#define __GPIO_STATIC_PORT_P3 GPIO_PORT3
+#define __GPIO_STATIC_PORT_P4 GPIO_PORT4
+#define __GPIO_STATIC_PORT_P5 GPIO_PORT5
+#define __GPIO_STATIC_PORT_P6 GPIO_PORT6
+#define __GPIO_STATIC_PORT_P7 GPIO_PORT7
+
+#define gpioStaticWrite(staticPin, value) staticPin = (value)
+#define gpioStaticRead(staticPin) (staticPin)
+#define gpioStaticToggle(staticPin) staticPin = !staticPin
+
+#ifdef HAL_GPIO_API_INTERRUPT
+	#ifndef GPIO_HAS_INT_WK
+		#error "HAL_GPIO_API_INTERRUPT requires an MCU with pin interrupts"
+	#endif // GPIO_HAS_INT_WK
+	
+	#ifndef GPIO_INTERRUPT_PORTS
+		#define GPIO_INTERRUPT_PORTS 0xff
+	#endif // GPIO_INTERRUPT_PORTS
+	
+	/**
+	 * Pin interrupt handler. It's called from the port's ISR, with
+	 * the value of GPIO_INTERRUPT_TIMESTAMP when the ISR started.
+	 * 
+	 * SDCC can only call a function taking several arguments through
+	 * a pointer if it's reentrant, so handlers MUST be declared
+	 * REENTRANT.
+	 */
+	typedef void (*GpioPinHandler)(GpioPort port, GpioPin pin, uint16_t timestamp) REENTRANT;
+	
+	/**
+	 * The application MUST define this table, indexed by port then pin
+	 * number, e.g.:
+	 * 
+	 *     void onButtonPressed(GpioPort port, GpioPin pin, uint16_t timestamp) REENTRANT {
+	 *         // ...
+	 *     }
+	 * 
+	 *     const GpioPinHandler __code gpioPinHandlers[8][8] = {
+	 *         [GPIO_PORT3] = { [GPIO_PIN2] = onButtonPressed },
+	 *     };
+	 * 
+	 * Pin interrupts are enabled with gpioConfigure(). When several
+	 * pins of a port are pending, their handlers are called in pin
+	 * order. Pins whose entry is NULL are ignored.
+	 * 
+	 * Handlers of all ports share the dispatcher, so all port
+	 * interrupts MUST have the same priority (which is the default).
+	 */
+	extern const GpioPinHandler __code gpioPinHandlers[8][8];
+	
+	#if defined(GPIO_HAS_P0) && (GPIO_INTERRUPT_PORTS & 0x01)
+		INTERRUPT(gpio_p0_isr, P0_INTERRUPT);
+	#endif
+	#if defined(GPIO_HAS_P1) && (GPIO_INTERRUPT_PORTS & 0x02)
+		INTERRUPT(gpio_p1_isr, P1_INTERRUPT);
+	#endif
+	#if defined(GPIO_HAS_P2) && (GPIO_INTERRUPT_PORTS & 0x04)
+		INTERRUPT(gpio_p2_isr, P2_INTERRUPT);
+	#endif
+	#if GPIO_INTERRUPT_PORTS & 0x08
+		INTERRUPT(gpio_p3_isr, P3_INTERRUPT);
+	#endif
+	#if defined(GPIO_HAS_P4) && (GPIO_INTERRUPT_PORTS & 0x10)
+		INTERRUPT(gpio_p4_isr, P4_INTERRUPT);
+	#endif
+	#if defined(GPIO_HAS_P5) && (GPIO_INTERRUPT_PORTS & 0x20)
+		INTERRUPT(gpio_p5_isr, P5_INTERRUPT);
+	#endif
+	#if defined(GPIO_HAS_P6) && (GPIO_INTERRUPT_PORTS & 0x40)
+		INTERRUPT(gpio_p6_isr, P6_INTERRUPT);
+	#endif
+	#if defined(GPIO_HAS_P7) && (GPIO_INTERRUPT_PORTS & 0x80)
+		INTERRUPT(gpio_p7_isr, P7_INTERRUPT);
+	#endif
+#endif // HAL_GPIO_API_INTERRUPT
+
 #endif // _GPIO_HAL_H
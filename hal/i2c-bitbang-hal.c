@@ -0,0 +1,267 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ * 
+ * Copyright (c) 2023 Vincent DEFERT. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions 
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in the 
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "project-defs.h"
+#include <i2c-hal.h>
+#include <gpio-hal.h>
+
+/**
+ * @file i2c-bitbang-hal.c
+ * 
+ * Software I2C master implementation, for MCU without an I2C
+ * peripheral (STC12, STC15, STC90). It implements the master mode API
+ * of i2c-hal.h, so link this file instead of i2c-hal.c.
+ * 
+ * SCL and SDA are accessed directly as static pins (see gpio-hal.h),
+ * so the application MUST define which ones they are in
+ * project-defs.h, e.g.:
+ * 
+ *     #define I2C_BITBANG_SCL GPIO_STATIC_PIN(P3, 2)
+ *     #define I2C_BITBANG_SDA GPIO_STATIC_PIN(P3, 3)
+ * 
+ * Both pins MUST be configured in open drain or quasi-bidirectional
+ * mode. Slaves stretching the clock are supported.
+ */
+
+#if defined(I2C_IS_SLAVE) || defined(HAL_I2C_API_ASYNC)
+	#error "i2c-bitbang-hal only supports blocking master mode"
+#endif
+
+#if !defined(I2C_BITBANG_SCL) || !defined(I2C_BITBANG_SDA)
+	#error "I2C_BITBANG_SCL and I2C_BITBANG_SDA MUST be defined"
+#endif
+
+/*
+ * Each half-period of SCL is made of the pin access code, including
+ * the call to __i2cDelay(), followed by the delay loop. The cost of
+ * one loop iteration is the same as in delay10us() (see delay.c), the
+ * overhead is estimated from each core's instruction timings. For the
+ * STC90, it's STC12's scaled by the ratio of delay10us()'s per-call
+ * overheads (120 vs 16 cycles in 12T mode).
+ * 
+ * The overhead sets the highest reachable clock rate: with STC12/STC15
+ * @ 24 MHz, it's most of a 400 kHz half-period (30 cycles), so the
+ * delay loop runs once. With STC90 @ 11.0592 MHz in 12T mode, it's
+ * over 3 times a 100 kHz half-period, so the clock is slower than
+ * requested whatever the delay.
+ */
+#if MCU_FAMILY == 8
+	#define I2C_DELAY_LOOP_CYCLES 6UL
+	#define I2C_DELAY_OVERHEAD_CYCLES 16UL
+#elif MCU_FAMILY == 12 || MCU_FAMILY == 15
+	#define I2C_DELAY_LOOP_CYCLES 10UL
+	#define I2C_DELAY_OVERHEAD_CYCLES 24UL
+#elif MCU_FAMILY == 90
+	#if MCU_CYCLES == 6
+		#define I2C_DELAY_LOOP_CYCLES 36UL
+		#define I2C_DELAY_OVERHEAD_CYCLES 90UL
+	#else
+		#define I2C_DELAY_LOOP_CYCLES 72UL
+		#define I2C_DELAY_OVERHEAD_CYCLES 180UL
+	#endif // MCU_CYCLES == 6
+#else
+	#error "Unsupported MCU family"
+#endif // MCU_FAMILY
+
+static I2C_SEGMENT uint8_t __i2cDelayCount;
+
+static void __i2cDelay() {
+	for (uint8_t n = __i2cDelayCount; n; n--) {
+	}
+}
+
+// Releases SCL, then waits for slaves stretching the clock.
+#define __i2cSclHigh() do { \
+	gpioStaticWrite(I2C_BITBANG_SCL, 1); \
+	while (!gpioStaticRead(I2C_BITBANG_SCL)); \
+} while (0)
+
+#define __i2cWriteBit(value) do { \
+	gpioStaticWrite(I2C_BITBANG_SDA, (value)); \
+	__i2cDelay(); \
+	__i2cSclHigh(); \
+	__i2cDelay(); \
+	gpioStaticWrite(I2C_BITBANG_SCL, 0); \
+} while (0)
+
+// SDA MUST have been released beforehand.
+#define __i2cReadBit(byte, mask) do { \
+	__i2cDelay(); \
+	__i2cSclHigh(); \
+	__i2cDelay(); \
+	\
+	if (gpioStaticRead(I2C_BITBANG_SDA)) { \
+		byte |= (mask); \
+	} \
+	\
+	gpioStaticWrite(I2C_BITBANG_SCL, 0); \
+} while (0)
+
+// Suppress warning "unreferenced function argument"
+#pragma save
+#pragma disable_warning 85
+
+// pinSwitch is unused, pins being defined by I2C_BITBANG_SCL and
+// I2C_BITBANG_SDA.
+void i2cInitialiseMaster(uint8_t pinSwitch, uint32_t i2cFreq) {
+	uint32_t halfPeriod = MCU_FREQ / i2cFreq / 2;
+	uint32_t count = 0;
+	
+	if (halfPeriod > I2C_DELAY_OVERHEAD_CYCLES) {
+		// Rounded to the closest integer
+		count = (halfPeriod - I2C_DELAY_OVERHEAD_CYCLES + I2C_DELAY_LOOP_CYCLES / 2) / I2C_DELAY_LOOP_CYCLES;
+	}
+	
+	__i2cDelayCount = (count > 255) ? 255 : count;
+	gpioStaticWrite(I2C_BITBANG_SDA, 1);
+	gpioStaticWrite(I2C_BITBANG_SCL, 1);
+}
+
+#pragma restore
+
+// Also works as a repeated start, since SCL is low after any byte.
+void i2cStart() {
+	gpioStaticWrite(I2C_BITBANG_SDA, 1);
+	__i2cDelay();
+	__i2cSclHigh();
+	__i2cDelay();
+	gpioStaticWrite(I2C_BITBANG_SDA, 0);
+	__i2cDelay();
+	gpioStaticWrite(I2C_BITBANG_SCL, 0);
+}
+
+void i2cStop() {
+	gpioStaticWrite(I2C_BITBANG_SDA, 0);
+	__i2cDelay();
+	__i2cSclHigh();
+	__i2cDelay();
+	gpioStaticWrite(I2C_BITBANG_SDA, 1);
+	__i2cDelay();
+}
+
+void i2cSendAck(I2C_AckNak value) {
+	__i2cWriteBit(value);
+}
+
+// Unrolled, as a loop would take longer than a 400 kHz bit.
+void i2cSendData(uint8_t byte) {
+	__i2cWriteBit(byte & 0x80);
+	__i2cWriteBit(byte & 0x40);
+	__i2cWriteBit(byte & 0x20);
+	__i2cWriteBit(byte & 0x10);
+	__i2cWriteBit(byte & 0x08);
+	__i2cWriteBit(byte & 0x04);
+	__i2cWriteBit(byte & 0x02);
+	__i2cWriteBit(byte & 0x01);
+}
+
+I2C_AckNak i2cReceiveAck() {
+	uint8_t result = 0;
+	gpioStaticWrite(I2C_BITBANG_SDA, 1);
+	__i2cReadBit(result, I2C_NAK);
+	
+	return (I2C_AckNak) result;
+}
+
+uint8_t i2cReceiveData() {
+	uint8_t result = 0;
+	gpioStaticWrite(I2C_BITBANG_SDA, 1);
+	__i2cReadBit(result, 0x80);
+	__i2cReadBit(result, 0x40);
+	__i2cReadBit(result, 0x20);
+	__i2cReadBit(result, 0x10);
+	__i2cReadBit(result, 0x08);
+	__i2cReadBit(result, 0x04);
+	__i2cReadBit(result, 0x02);
+	__i2cReadBit(result, 0x01);
+	
+	return result;
+}
+
+I2C_AckNak i2cStartCommand(uint8_t slaveAddress, I2C_Command command) {
+	i2cStart();
+	i2cSendData((slaveAddress << 1) | command);
+	
+	return i2cReceiveAck();
+}
+
+I2C_AckNak i2cSendByte(uint8_t byte) {
+	i2cSendData(byte);
+	
+	return i2cReceiveAck();
+}
+
+uint8_t i2cReadByteSendAck(I2C_AckNak value) {
+	uint8_t result = i2cReceiveData();
+	i2cSendAck(value);
+	
+	return result;
+}
+
+I2C_AckNak i2cWriteRegisters(uint8_t slaveAddress, uint8_t registerAddress, const uint8_t *data, uint8_t count) {
+	I2C_AckNak result = i2cStartCommand(slaveAddress, I2C_WRITE);
+	
+	if (result == I2C_ACK) {
+		result = i2cSendByte(registerAddress);
+	}
+	
+	for (uint8_t i = 0; i < count && result == I2C_ACK; i++) {
+		result = i2cSendByte(data[i]);
+	}
+	
+	i2cStop();
+	
+	return result;
+}
+
+I2C_AckNak i2cReadRegisters(uint8_t slaveAddress, uint8_t registerAddress, uint8_t *data, uint8_t count) {
+	I2C_AckNak result = i2cStartCommand(slaveAddress, I2C_WRITE);
+	
+	if (result == I2C_ACK) {
+		result = i2cSendByte(registerAddress);
+	}
+	
+	if (result == I2C_ACK) {
+		// Repeated start
+		result = i2cStartCommand(slaveAddress, I2C_READ);
+	}
+	
+	if (result == I2C_ACK) {
+		uint8_t last = count - 1;
+		
+		for (uint8_t i = 0; i < count; i++) {
+			// NAK the last byte to tell the slave we're done
+			data[i] = i2cReadByteSendAck((i == last) ? I2C_NAK : I2C_ACK);
+		}
+	}
+	
+	i2cStop();
+	
+	return result;
+}
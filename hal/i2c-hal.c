@@ -95,7 +95,7 @@ static void __i2c_configurePins(uint8_t pinSwitch) {
 			pinConfig.port = (GpioPort) (pinDefinition >> 4);
 			pinConfig.pin = (GpioPin) (pinDefinition & 0x0f);
 #ifdef I2C_IS_SLAVE
-			pinConfig.portMode = GPIO_BIDIRECTIONAL_MODE;
+			pinConfig.pinMode = GPIO_BIDIRECTIONAL_MODE;
 #endif // I2C_IS_SLAVE
 			gpioConfigure(&pinConfig);
 			break;
@@ -133,6 +133,94 @@ static void __i2c_configurePins(uint8_t pinSwitch) {
 		}
 	}
 
+#ifdef HAL_I2C_API_REGISTER_FILE
+	static I2C_SEGMENT struct {
+		uint8_t *registers;
+		const uint8_t *writeProtect;
+		uint8_t size;
+		uint8_t pointer; /*!< Next register to read or write. */
+		bool pointerExpected; /*!< Next byte received sets the pointer. */
+		uint8_t firstWritten; /*!< First register written by the current transaction. */
+		uint8_t written; /*!< Registers written by the current transaction. */
+	} __i2cRegisterFile;
+	
+	void i2cRegisterFileInitialise(uint8_t *registers, const uint8_t *writeProtect, uint8_t size) {
+		__i2cRegisterFile.registers = registers;
+		__i2cRegisterFile.writeProtect = writeProtect;
+		__i2cRegisterFile.size = size;
+		__i2cRegisterFile.pointer = 0;
+		__i2cRegisterFile.pointerExpected = false;
+		__i2cRegisterFile.written = 0;
+	}
+	
+	static void __i2cNextRegister() {
+		__i2cRegisterFile.pointer++;
+		
+		if (__i2cRegisterFile.pointer == __i2cRegisterFile.size) {
+			__i2cRegisterFile.pointer = 0;
+		}
+	}
+	
+	// Signals writes at the end of a transaction, be it a stop
+	// condition or a repeated start.
+	static void __i2cEndOfTransaction() {
+		if (__i2cRegisterFile.written) {
+			i2cOnRegistersWritten(__i2cRegisterFile.firstWritten, __i2cRegisterFile.written);
+			__i2cRegisterFile.written = 0;
+		}
+	}
+	
+	INTERRUPT(i2c_isr, I2C_INTERRUPT) {
+		uint8_t flags = I2CSLST;
+		
+		if (flags & M_STOIF) {
+			I2CSLST &= ~M_STOIF;
+			__i2c_startReceived = false;
+			__i2cEndOfTransaction();
+		} else if (flags & M_TXIF) {
+			I2CSLST &= ~M_TXIF;
+			__i2cNextRegister();
+			
+			// The master NAKs the last byte it wants
+			if (!(I2CSLST & M_SLACKI)) {
+				I2CTXD = __i2cRegisterFile.registers[__i2cRegisterFile.pointer];
+			}
+		} else if (flags & M_RXIF) {
+			I2CSLST &= ~M_RXIF;
+			uint8_t byte = I2CRXD;
+			uint8_t pointer = __i2cRegisterFile.pointer;
+			
+			if (__i2c_startReceived) {
+				__i2c_startReceived = false;
+				
+				if (byte & I2C_READ) {
+					I2CTXD = __i2cRegisterFile.registers[pointer];
+				} else {
+					__i2cRegisterFile.pointerExpected = true;
+				}
+			} else if (__i2cRegisterFile.pointerExpected) {
+				__i2cRegisterFile.pointerExpected = false;
+				__i2cRegisterFile.pointer = (byte < __i2cRegisterFile.size) ? byte : 0;
+			} else {
+				if (!(__i2cRegisterFile.writeProtect
+					&& (__i2cRegisterFile.writeProtect[pointer >> 3] & (1 << (pointer & 7))))) {
+					__i2cRegisterFile.registers[pointer] = byte;
+				}
+				
+				if (!__i2cRegisterFile.written) {
+					__i2cRegisterFile.firstWritten = pointer;
+				}
+				
+				__i2cRegisterFile.written++;
+				__i2cNextRegister();
+			}
+		} else if (flags & M_STAIF) {
+			I2CSLST &= ~M_STAIF;
+			__i2c_startReceived = true;
+			__i2cEndOfTransaction();
+		}
+	}
+#else
 	INTERRUPT(i2c_isr, I2C_INTERRUPT) {
 		uint8_t p_sw2 = P_SW2;
 		uint8_t flags = I2CSLST;
@@ -164,6 +252,7 @@ static void __i2c_configurePins(uint8_t pinSwitch) {
 			__i2c_startReceived = true;
 		}
 	}
+#endif // HAL_I2C_API_REGISTER_FILE
 #else
 	// == MASTER mode ==================================================
 	enum  I2C_Operations {
@@ -274,4 +363,191 @@ static void __i2c_configurePins(uint8_t pinSwitch) {
 		
 		return result;
 	}
+	
+	/*
+	 * The register functions below issue the controller's commands
+	 * directly rather than calling the functions above, which saves a
+	 * call and a return per byte.
+	 */
+	
+	#define __i2cAckReceived() ((I2C_AckNak) ((I2CMSST & M_MSACKI) >> P_MSACKI))
+	
+	static I2C_AckNak __i2cSelectRegister(uint8_t slaveAddress, uint8_t registerAddress) {
+		I2C_AckNak result = i2cStartCommand(slaveAddress, I2C_WRITE);
+		
+		if (result == I2C_ACK) {
+			I2CTXD = registerAddress;
+			I2CMSCR = I2C_sendData_receiveAck;
+			__waitForCompletion();
+			result = __i2cAckReceived();
+		}
+		
+		return result;
+	}
+	
+	I2C_AckNak i2cWriteRegisters(uint8_t slaveAddress, uint8_t registerAddress, const uint8_t *data, uint8_t count) {
+		I2C_AckNak result = __i2cSelectRegister(slaveAddress, registerAddress);
+		
+		for (uint8_t i = 0; i < count && result == I2C_ACK; i++) {
+			I2CTXD = data[i];
+			I2CMSCR = I2C_sendData_receiveAck;
+			__waitForCompletion();
+			result = __i2cAckReceived();
+		}
+		
+		i2cStop();
+		
+		return result;
+	}
+	
+	I2C_AckNak i2cReadRegisters(uint8_t slaveAddress, uint8_t registerAddress, uint8_t *data, uint8_t count) {
+		I2C_AckNak result = __i2cSelectRegister(slaveAddress, registerAddress);
+		
+		if (result == I2C_ACK) {
+			// Repeated start
+			result = i2cStartCommand(slaveAddress, I2C_READ);
+		}
+		
+		if (result == I2C_ACK) {
+			uint8_t last = count - 1;
+			
+			for (uint8_t i = 0; i < count; i++) {
+				// NAK the last byte to tell the slave we're done
+				I2CMSCR = (i == last) ? I2C_receiveData_sendAck1 : I2C_receiveData_sendAck0;
+				__waitForCompletion();
+				data[i] = I2CRXD;
+			}
+		}
+		
+		i2cStop();
+		
+		return result;
+	}
+	
+	#ifdef HAL_I2C_API_ASYNC
+		// What the command in progress is doing.
+		typedef enum {
+			I2C_PHASE_WRITE,
+			I2C_PHASE_READ_ADDRESS,
+			I2C_PHASE_READ,
+			I2C_PHASE_STOP,
+		} I2cPhase;
+		
+		static I2C_SEGMENT struct {
+			I2cTransaction *head; /*!< Transaction in progress, NULL when idle. */
+			I2cTransaction *tail; /*!< Last queued transaction. */
+			uint8_t phase;
+			uint8_t index;
+		} __i2cQueue;
+		
+		#define __i2cCommand(command) I2CMSCR = M_EMSI | (command)
+		
+		/*
+		 * The functions below are called both from i2c_isr and from
+		 * the main loop. In the latter case, they MUST be called with
+		 * interrupts disabled.
+		 */
+		
+		static void __i2cStartTransaction(I2cTransaction *transaction) {
+			__i2cQueue.index = 0;
+			
+			if (transaction->txSize) {
+				__i2cQueue.phase = I2C_PHASE_WRITE;
+				I2CTXD = (transaction->slaveAddress << 1) | I2C_WRITE;
+			} else {
+				__i2cQueue.phase = I2C_PHASE_READ_ADDRESS;
+				I2CTXD = (transaction->slaveAddress << 1) | I2C_READ;
+			}
+			
+			__i2cCommand(I2C_start_sendData_receiveAck);
+		}
+		
+		static void __i2cReceiveNext(I2cTransaction *transaction) {
+			__i2cQueue.phase = I2C_PHASE_READ;
+			__i2cCommand((__i2cQueue.index == transaction->rxSize - 1)
+				? I2C_receiveData_sendAck1
+				: I2C_receiveData_sendAck0);
+		}
+		
+		static void __i2cStop() {
+			__i2cQueue.phase = I2C_PHASE_STOP;
+			__i2cCommand(I2C_stop);
+		}
+		
+		void i2cSubmit(I2cTransaction *transaction) {
+			transaction->next = NULL;
+			transaction->complete = false;
+			transaction->result = I2C_ACK;
+			
+			CRITICAL {
+				if (__i2cQueue.head) {
+					__i2cQueue.tail->next = transaction;
+				} else {
+					__i2cQueue.head = transaction;
+					__i2cStartTransaction(transaction);
+				}
+				
+				__i2cQueue.tail = transaction;
+			}
+		}
+		
+		INTERRUPT(i2c_isr, I2C_INTERRUPT) {
+			I2cTransaction *transaction = __i2cQueue.head;
+			I2CMSST &= ~M_MSIF;
+			
+			switch (__i2cQueue.phase) {
+			case I2C_PHASE_WRITE:
+				// Slave address or data byte sent
+				if (I2CMSST & M_MSACKI) {
+					transaction->result = I2C_NAK;
+					__i2cStop();
+				} else if (__i2cQueue.index < transaction->txSize) {
+					I2CTXD = transaction->tx[__i2cQueue.index];
+					__i2cQueue.index++;
+					__i2cCommand(I2C_sendData_receiveAck);
+				} else if (transaction->rxSize) {
+					// Repeated start
+					__i2cQueue.phase = I2C_PHASE_READ_ADDRESS;
+					I2CTXD = (transaction->slaveAddress << 1) | I2C_READ;
+					__i2cCommand(I2C_start_sendData_receiveAck);
+				} else {
+					__i2cStop();
+				}
+				break;
+			
+			case I2C_PHASE_READ_ADDRESS:
+				if (I2CMSST & M_MSACKI) {
+					transaction->result = I2C_NAK;
+					__i2cStop();
+				} else {
+					__i2cQueue.index = 0;
+					__i2cReceiveNext(transaction);
+				}
+				break;
+			
+			case I2C_PHASE_READ:
+				transaction->rx[__i2cQueue.index] = I2CRXD;
+				__i2cQueue.index++;
+				
+				if (__i2cQueue.index < transaction->rxSize) {
+					__i2cReceiveNext(transaction);
+				} else {
+					__i2cStop();
+				}
+				break;
+			
+			case I2C_PHASE_STOP:
+				transaction->complete = true;
+				transaction = transaction->next;
+				__i2cQueue.head = transaction;
+				
+				if (transaction) {
+					__i2cStartTransaction(transaction);
+				} else {
+					I2CMSCR = I2C_standby;
+				}
+				break;
+			}
+		}
+	#endif // HAL_I2C_API_ASYNC
 #endif // I2C_IS_SLAVE
@@ -38,6 +38,11 @@
  * Supported MCU:
  * 
  *     STC8*
+ *     STC12*, STC15* (master mode only, through i2c-bitbang-hal.c)
+ * 
+ * The master mode API is also implemented in software by
+ * i2c-bitbang-hal.c, which can be linked instead of i2c-hal.c on STC8,
+ * STC12, STC15 and STC90 MCU. See that file for its configuration.
  * 
  * Dependencies:
  * 
@@ -50,6 +55,12 @@
  *     time. Insignificant impact on RAM footprint, unless moving
  *     a single byte here and there would help.
  * 
+ *     HAL_I2C_API_REGISTER_FILE (default: undefined, slave mode only)
+ *     enables the register file mode, see i2cRegisterFileInitialise().
+ * 
+ *     HAL_I2C_API_ASYNC (default: undefined, master mode only) enables
+ *     interrupt-driven transactions, see i2cSubmit().
+ * 
  * **IMPORTANT:** In order to satisfy SDCC's requirements for ISR 
  * handling, this header file **MUST** be included in the C source 
  * file where main() is defined.
@@ -112,14 +123,42 @@ typedef enum {
 	 */
 	void i2cSendAck(I2C_AckNak value);
 	
-	/**
-	 * The following event handlers MUST be implemented,
-	 * even when not used.
-	 */
-	void i2cOnCommandReceived(uint8_t slaveAddress, I2C_Command command);
-	void i2cOnDataReceived(uint8_t byte);
-	void i2cOnDataSent(I2C_AckNak ack);
-	void i2cOnStop();
+	#ifdef HAL_I2C_API_REGISTER_FILE
+		/**
+		 * Exposes registers[0..size - 1] to the master, the way most I2C
+		 * peripherals do. The first byte of a write transaction sets the
+		 * register pointer, following bytes are written from there. A
+		 * read transaction returns registers from the register pointer.
+		 * The pointer is incremented after each byte, and wraps around
+		 * to 0 after the last register.
+		 * 
+		 * writeProtect is a bit array with one bit per register (LSB of
+		 * writeProtect[0] for register 0): writes to registers whose bit
+		 * is set are acknowledged but ignored. It may be NULL, and may
+		 * point to __code.
+		 * 
+		 * Everything is handled by i2c_isr, so i2cSendData(), i2cSendAck()
+		 * and the per-byte event handlers below aren't used.
+		 */
+		void i2cRegisterFileInitialise(uint8_t *registers, const uint8_t *writeProtect, uint8_t size);
+		
+		/**
+		 * The following event handler MUST be implemented. It's called
+		 * from i2c_isr at the end of a write transaction which wrote
+		 * count bytes starting at register firstRegister (count may
+		 * wrap around the end of the register file).
+		 */
+		void i2cOnRegistersWritten(uint8_t firstRegister, uint8_t count);
+	#else
+		/**
+		 * The following event handlers MUST be implemented,
+		 * even when not used.
+		 */
+		void i2cOnCommandReceived(uint8_t slaveAddress, I2C_Command command);
+		void i2cOnDataReceived(uint8_t byte);
+		void i2cOnDataSent(I2C_AckNak ack);
+		void i2cOnStop();
+	#endif // HAL_I2C_API_REGISTER_FILE
 
 	INTERRUPT(i2c_isr, I2C_INTERRUPT);
 #else
@@ -141,6 +180,54 @@ typedef enum {
 	void i2cSendData(uint8_t byte);
 	I2C_AckNak i2cReceiveAck();
 	uint8_t i2cReceiveData();
+	
+	/**
+	 * Writes count bytes from data to the consecutive registers of
+	 * slaveAddress starting at registerAddress, in a single transaction.
+	 * Returns I2C_NAK as soon as the slave fails to acknowledge a byte.
+	 */
+	I2C_AckNak i2cWriteRegisters(uint8_t slaveAddress, uint8_t registerAddress, const uint8_t *data, uint8_t count);
+	
+	/**
+	 * Reads count bytes into data from the consecutive registers of
+	 * slaveAddress starting at registerAddress. The register address is
+	 * written, then data is read after a repeated start. Returns I2C_NAK
+	 * if the slave fails to acknowledge the address or the register.
+	 */
+	I2C_AckNak i2cReadRegisters(uint8_t slaveAddress, uint8_t registerAddress, uint8_t *data, uint8_t count);
+	
+	#ifdef HAL_I2C_API_ASYNC
+		/**
+		 * A transaction with a slave: txSize bytes are written from tx,
+		 * then rxSize bytes are read into rx after a repeated start.
+		 * Either part may be empty, but not both.
+		 */
+		typedef struct I2cTransaction {
+			uint8_t slaveAddress; /*!< 7-bit slave address. */
+			const uint8_t *tx;
+			uint8_t txSize;
+			uint8_t *rx;
+			uint8_t rxSize;
+			volatile bool complete; /*!< Set once the stop condition has been sent. */
+			volatile I2C_AckNak result; /*!< I2C_NAK if the slave didn't acknowledge a byte written. */
+			struct I2cTransaction *next; /*!< Reserved for the HAL. */
+		} I2cTransaction;
+		
+		/**
+		 * Queues transaction and returns immediately. Start, address,
+		 * data, acknowledge and stop are sequenced by i2c_isr, so the
+		 * main loop stays free while the bus is busy. The transaction
+		 * is aborted with a stop condition as soon as the slave replies
+		 * with a NAK.
+		 * 
+		 * The transaction and its buffers MUST remain untouched until
+		 * transaction->complete is set, and the blocking functions above
+		 * MUST NOT be used while transactions are queued.
+		 */
+		void i2cSubmit(I2cTransaction *transaction);
+		
+		INTERRUPT(i2c_isr, I2C_INTERRUPT);
+	#endif // HAL_I2C_API_ASYNC
 #endif // I2C_IS_SLAVE
 
 #endif // _I2C_HAL_H
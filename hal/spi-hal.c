@@ -30,7 +30,6 @@
 #include "project-defs.h"
 #include <spi-hal.h>
 #include <gpio-hal.h>
-#include <string.h>
 
 /**
  * @file spi-hal.c
@@ -159,14 +158,42 @@ static void __spi_configurePins(SpiMode spiMode, uint8_t pinSwitch, GpioPinMode
 	}
 }
 
+#ifndef SPI_FILL_BYTE
+	#define SPI_FILL_BYTE 0
+#endif
+
 static SPI_SEGMENT struct {
 	uint8_t mode;
-	uint8_t *buffer;
-	size_t index;
-	size_t bufferSize;
+	const uint8_t *tx; /*!< Byte being sent. */
+	uint8_t *rx; /*!< Where to store the next byte received. */
+	uint8_t txStep; /*!< 0 when sending SPI_FILL_BYTE, 1 otherwise. */
+	uint8_t rxStep; /*!< 0 when discarding received bytes, 1 otherwise. */
+	SpiIndex remaining;
 	bool *readyFlag;
 } __spiState;
 
+// A NULL tx or rx is replaced by one of these with a step of 0, so
+// that spi_isr doesn't have to test the buffers for each byte.
+static const uint8_t __code __spiFillByte = SPI_FILL_BYTE;
+static uint8_t __spiDiscard;
+
+static void __spiSetBuffers(const uint8_t *tx, uint8_t *rx, SpiIndex size) {
+	__spiState.tx = tx ? tx : &__spiFillByte;
+	__spiState.txStep = tx ? 1 : 0;
+	__spiState.rx = rx ? rx : &__spiDiscard;
+	__spiState.rxStep = rx ? 1 : 0;
+	__spiState.remaining = size;
+}
+
+// Lets the compiler drop the code for the unused mode.
+#if defined(SPI_MASTER_ONLY)
+	#define __spiIsMaster() true
+#elif defined(SPI_SLAVE_ONLY)
+	#define __spiIsMaster() false
+#else
+	#define __spiIsMaster() (__spiState.mode == SPI_MASTER)
+#endif
+
 SpiSpeed spiSelectSpeed(uint32_t maxDeviceRate) {
 	uint16_t divisor = (uint16_t) (MCU_FREQ / maxDeviceRate);
 	
@@ -231,54 +258,361 @@ void spiConfigure(SpiMode spiMode, SpiBitOrder bitOrder, SpiPolarity polarity, S
 		: (IE2 | M_ESPI);
 }
 
-void spiSend(uint8_t *buffer, size_t bufferSize, bool *readyFlag) {
-	__spiState.buffer = buffer;
-	__spiState.bufferSize = bufferSize;
+#ifdef HAL_SPI_API_QUEUE
+	static SPI_SEGMENT struct {
+		SpiJob *head; /*!< Job in progress. */
+		SpiJob *tail; /*!< Last queued job. */
+		SpiSegment *segment; /*!< Segment in progress, NULL when idle. */
+	} __spiQueue;
+	
+	/*
+	 * gpioWrite() isn't reentrant and does a read-modify-write of the
+	 * whole port, so it can't be used from the ISR. A single ANL or ORL
+	 * on the port is atomic.
+	 */
+	#define SPI_CS_PORT(n) \
+		case GPIO_PORT ## n: \
+			if (selected) { \
+				P ## n &= ~mask; \
+			} else { \
+				P ## n |= mask; \
+			} \
+			break;
+	
+	static void __spiChipSelect(SpiDevice *device, bool selected) {
+		uint8_t mask = device->cs.__setMask;
+		
+		switch (device->cs.port) {
+	#ifdef GPIO_HAS_P0
+		SPI_CS_PORT(0)
+	#endif // GPIO_HAS_P0
+	#ifdef GPIO_HAS_P1
+		SPI_CS_PORT(1)
+	#endif // GPIO_HAS_P1
+	#ifdef GPIO_HAS_P2
+		SPI_CS_PORT(2)
+	#endif // GPIO_HAS_P2
+		SPI_CS_PORT(3)
+	#ifdef GPIO_HAS_P4
+		SPI_CS_PORT(4)
+	#endif // GPIO_HAS_P4
+	#ifdef GPIO_HAS_P5
+		SPI_CS_PORT(5)
+	#endif // GPIO_HAS_P5
+	#ifdef GPIO_HAS_P6
+		SPI_CS_PORT(6)
+	#endif // GPIO_HAS_P6
+	#ifdef GPIO_HAS_P7
+		SPI_CS_PORT(7)
+	#endif // GPIO_HAS_P7
+		}
+	}
+	
+	/*
+	 * The functions below are called both from spi_isr and from the
+	 * main loop. In the latter case, they MUST be called with interrupts
+	 * disabled.
+	 */
+	
+	static void __spiSelectJob(SpiJob *job) {
+		SPCTL = job->device->spctl;
+		__spiChipSelect(job->device, true);
+	}
+	
+	// Starts the first non-empty segment from segment on, completing
+	// the job in progress and moving on to the next ones as needed.
+	// __spiQueue.segment is NULL once there's nothing left to transfer.
+	static void __spiStartSegment(SpiSegment *segment) {
+		SpiJob *job = __spiQueue.head;
+		
+		for (;;) {
+			while (segment && segment->size == 0) {
+				segment = segment->next;
+			}
+			
+			if (segment) {
+				__spiQueue.segment = segment;
+				__spiSetBuffers(segment->tx, segment->rx, segment->size);
+				SPDAT = *__spiState.tx;
+				break;
+			}
+			
+			__spiChipSelect(job->device, false);
+			job->complete = true;
+			job = job->next;
+			__spiQueue.head = job;
+			
+			if (job == NULL) {
+				__spiQueue.segment = NULL;
+				break;
+			}
+			
+			__spiSelectJob(job);
+			segment = job->segments;
+		}
+	}
+	
+	void spiDeviceInitialise(SpiDevice *device, SpiBitOrder bitOrder, SpiPolarity polarity, SpiPhase phase, SpiSpeed speed) {
+		device->spctl = SPI_MASTER | bitOrder | polarity | phase | speed;
+		gpioConfigure(&device->cs);
+		gpioWrite(&device->cs, 1);
+	}
+	
+	void spiSubmit(SpiJob *job) {
+		job->next = NULL;
+		job->complete = false;
+		
+		CRITICAL {
+			if (__spiQueue.head) {
+				__spiQueue.tail->next = job;
+			} else {
+				__spiQueue.head = job;
+				__spiSelectJob(job);
+				__spiStartSegment(job->segments);
+			}
+			
+			__spiQueue.tail = job;
+		}
+	}
+#endif // HAL_SPI_API_QUEUE
+
+#ifdef HAL_SPI_API_SLAVE_STREAM
+	static SPI_SEGMENT struct {
+		FifoState *rx; /*!< NULL when not streaming. */
+		FifoState *tx;
+		uint16_t length; /*!< Bytes received in the current frame. */
+		bool pending; /*!< A reply byte sits in SPDAT but wasn't sent. */
+		uint8_t reply;
+	} __spiStream;
+	
+	// Loads the next reply byte into SPDAT. A byte taken from tx but
+	// left unsent when the master deselects us is kept for next frame.
+	static void __spiStreamLoadReply() {
+		if (!__spiStream.pending) {
+			__spiStream.pending = fifoRead(__spiStream.tx, &__spiStream.reply, 1);
+		}
+		
+		SPDAT = __spiStream.pending ? __spiStream.reply : SPI_FILL_BYTE;
+	}
+	
+	void spiSlaveStreamStart(FifoState *rx, FifoState *tx) {
+		CRITICAL {
+			__spiStream.tx = tx;
+			__spiStream.length = 0;
+			__spiStream.pending = false;
+			__spiStream.rx = rx;
+		}
+	}
+	
+	void spiSlaveStreamStop() {
+		CRITICAL {
+			__spiStream.rx = NULL;
+		}
+	}
+	
+	void spiSlaveSelectChanged(bool selected) {
+		if (__spiStream.rx) {
+			if (selected) {
+				__spiStream.length = 0;
+				spiOnSlaveFrameStart();
+				__spiStreamLoadReply();
+			} else {
+				spiOnSlaveFrameEnd(__spiStream.length);
+			}
+		}
+	}
+	
+	static INLINE void __spiSlaveStreamIsr() {
+		uint8_t data = SPDAT;
+		// The reply loaded beforehand has just been sent.
+		__spiStream.pending = false;
+		__spiStreamLoadReply();
+		
+		fifoWrite(__spiStream.rx, &data, 1);
+		__spiStream.length++;
+	}
+#endif // HAL_SPI_API_SLAVE_STREAM
+
+void spiTransfer(const uint8_t *tx, uint8_t *rx, size_t bufferSize, bool *readyFlag) {
+	__spiSetBuffers(tx, rx, (SpiIndex) bufferSize);
 	__spiState.readyFlag = readyFlag;
-	*__spiState.readyFlag = false;
-	__spiState.index = 0;
+	*__spiState.readyFlag = (bufferSize == 0);
 	
-	if (__spiState.mode == SPI_MASTER) {
-		SPDAT = __spiState.buffer[__spiState.index];
+	if (__spiIsMaster() && bufferSize) {
+		SPDAT = *__spiState.tx;
 	}
 }
 
+void spiSend(uint8_t *buffer, size_t bufferSize, bool *readyFlag) {
+	spiTransfer(buffer, buffer, bufferSize, readyFlag);
+}
+
 void spiReceive(uint8_t *buffer, size_t bufferSize, bool *readyFlag) {
-	memset(buffer, 0, bufferSize);
-	spiSend(buffer, bufferSize, readyFlag);
+	spiTransfer(NULL, buffer, bufferSize, readyFlag);
+}
+
+void spiTransferPolled(const uint8_t *tx, uint8_t *rx, size_t bufferSize) {
+	uint8_t espi = IE2 & M_ESPI;
+	IE2 &= ~M_ESPI;
+	
+	for (size_t i = 0; i < bufferSize; i++) {
+		SPDAT = tx ? tx[i] : SPI_FILL_BYTE;
+		
+		while (!(SPSTAT & M_SPIF));
+		
+		SPSTAT = M_SPIF | M_WCOL;
+		uint8_t data = SPDAT;
+		
+		if (rx) {
+			rx[i] = data;
+		}
+	}
+	
+	IE2 |= espi;
+}
+
+static INLINE void __spiMasterIsr() {
+	// Store slave's data (or discard it)
+	*__spiState.rx = SPDAT;
+	__spiState.rx += __spiState.rxStep;
+	__spiState.remaining--;
+	
+	if (__spiState.remaining) {
+		// Send next byte to slave
+		__spiState.tx += __spiState.txStep;
+		SPDAT = *__spiState.tx;
+#ifdef HAL_SPI_API_QUEUE
+	} else if (__spiQueue.segment) {
+		// Chain the next segment or job
+		__spiStartSegment(__spiQueue.segment->next);
+#endif // HAL_SPI_API_QUEUE
+	} else {
+		// We're done
+		*__spiState.readyFlag = true;
+	}
+}
+
+static INLINE void __spiSlaveIsr() {
+	// Take data from master
+	uint8_t data = SPDAT;
+	// Reply with slave's
+	SPDAT = *__spiState.tx;
+	__spiState.tx += __spiState.txStep;
+	
+	// Store master's data (or discard it)
+	*__spiState.rx = data;
+	__spiState.rx += __spiState.rxStep;
+	__spiState.remaining--;
+	
+	if (__spiState.remaining == 0) {
+		*__spiState.readyFlag = true;
+	}
 }
 
 INTERRUPT(spi_isr, SPI_INTERRUPT) {
 	SPSTAT |= M_SPIF | M_WCOL;
-	uint8_t data;
 	
-	switch (__spiState.mode) {
-	case SPI_MASTER:
-		// Replace master's data with slave's in buffer
-		__spiState.buffer[__spiState.index] = SPDAT;
-		__spiState.index++;
-		
-		if (__spiState.index < __spiState.bufferSize) {
-			// Send next byte to slave
-			SPDAT = __spiState.buffer[__spiState.index];
+#if defined(SPI_MASTER_ONLY)
+	__spiMasterIsr();
+#elif defined(SPI_SLAVE_ONLY)
+	#ifdef HAL_SPI_API_SLAVE_STREAM
+		if (__spiStream.rx) {
+			__spiSlaveStreamIsr();
 		} else {
-			// We're done
-			*__spiState.readyFlag = true;
+			__spiSlaveIsr();
 		}
+	#else
+		__spiSlaveIsr();
+	#endif // HAL_SPI_API_SLAVE_STREAM
+#else
+	switch (__spiState.mode) {
+	case SPI_MASTER:
+		__spiMasterIsr();
 		break;
 	
 	case SPI_SLAVE:
-		// Take data from master
-		data = SPDAT;
-		// Reply with slave's
-		SPDAT = __spiState.buffer[__spiState.index];
-		// Replace slave's data with master's in buffer
-		__spiState.buffer[__spiState.index] = data;
-		__spiState.index++;
-		
-		if (__spiState.index == __spiState.bufferSize) {
-			*__spiState.readyFlag = true;
+	#ifdef HAL_SPI_API_SLAVE_STREAM
+		if (__spiStream.rx) {
+			__spiSlaveStreamIsr();
+			break;
 		}
+	#endif // HAL_SPI_API_SLAVE_STREAM
+		__spiSlaveIsr();
 		break;
 	}
+#endif
 }
+
+#ifdef SPI_USE_DMA
+	// DMA_SPI_AMT holds the number of bytes to transfer minus 1.
+	#define SPI_DMA_MAX_TRANSFER 256
+	
+	static SPI_SEGMENT struct {
+		const __xdata uint8_t *tx;
+		__xdata uint8_t *rx;
+		size_t size;
+		size_t count;
+		bool *readyFlag;
+		uint8_t espi; /*!< ESPI bit of IE2 before the transfer. */
+	} __spiDmaState;
+	
+	static void __spiDmaStartNext() {
+		uint8_t cfg = M_DMA_INTERRUPT_ENABLE | M_ACT_TX;
+		uint16_t address = (uint16_t) __spiDmaState.tx;
+		
+		__spiDmaState.count = (__spiDmaState.size > SPI_DMA_MAX_TRANSFER) ? SPI_DMA_MAX_TRANSFER : __spiDmaState.size;
+		
+		DMA_SPI_STA = 0;
+		DMA_SPI_AMT = __spiDmaState.count - 1;
+		DMA_SPI_TXAH = address >> 8;
+		DMA_SPI_TXAL = address;
+		
+		if (__spiDmaState.rx) {
+			address = (uint16_t) __spiDmaState.rx;
+			DMA_SPI_RXAH = address >> 8;
+			DMA_SPI_RXAL = address;
+			cfg |= M_ACT_RX;
+		}
+		
+		DMA_SPI_CFG = cfg;
+		DMA_SPI_CR = M_DMA_CHANNEL_ENABLE | M_CLRFIFO
+			| (__spiIsMaster() ? M_TRIG_MASTER : M_TRIG_SLAVE);
+	}
+	
+	void spiTransferDma(const __xdata uint8_t *tx, __xdata uint8_t *rx, size_t size, bool *readyFlag) {
+		*readyFlag = size == 0;
+		
+		if (size) {
+			// SPIF is still set for each byte, so keep spi_isr out of
+			// the way until we're done.
+			__spiDmaState.espi = IE2 & M_ESPI;
+			IE2 &= ~M_ESPI;
+			
+			__spiDmaState.tx = tx;
+			__spiDmaState.rx = rx;
+			__spiDmaState.size = size;
+			__spiDmaState.readyFlag = readyFlag;
+			__spiDmaStartNext();
+		}
+	}
+	
+	INTERRUPT(spi_dma_isr, DMA_SPI_INTERRUPT) {
+		DMA_SPI_STA = 0;
+		__spiDmaState.size -= __spiDmaState.count;
+		
+		if (__spiDmaState.size) {
+			__spiDmaState.tx += __spiDmaState.count;
+			
+			if (__spiDmaState.rx) {
+				__spiDmaState.rx += __spiDmaState.count;
+			}
+			
+			__spiDmaStartNext();
+		} else {
+			DMA_SPI_CR = 0;
+			SPSTAT = M_SPIF | M_WCOL;
+			IE2 |= __spiDmaState.espi;
+			*__spiDmaState.readyFlag = true;
+		}
+	}
+#endif // SPI_USE_DMA
@@ -44,21 +44,69 @@
  * Dependencies:
  * 
  *     gpio-hal
+ *     fifo-buffer (HAL_SPI_API_SLAVE_STREAM only)
  * 
  * Optional macros:
  * 
  *     SPI_SEGMENT (default: __idata) defines where the HAL's state
  *     information will be stored. Impacts ISR execution time.
  * 
+ *     SPI_FILL_BYTE (default: 0) defines the byte sent by spiTransfer()
+ *     when tx is NULL.
+ * 
+ *     HAL_SPI_API_QUEUE (default: undefined) enables the transaction
+ *     queue, see spiSubmit().
+ * 
+ *     SPI_USE_DMA (default: undefined, requires MCU_HAS_DMA) enables
+ *     spiTransferDma(), which moves whole blocks between memory and
+ *     the SPI without taking an interrupt per byte. DMA registers
+ *     being extended SFRs, the application MUST enable access to
+ *     them with INIT_EXTENDED_SFR().
+ * 
+ *     HAL_SPI_API_SLAVE_STREAM (default: undefined) enables the slave
+ *     streaming mode, see spiSlaveStreamStart().
+ * 
+ *     SPI_MASTER_ONLY or SPI_SLAVE_ONLY (default: undefined) restrict
+ *     spi_isr to the corresponding mode, saving a test of the SPI mode
+ *     for each byte. spiConfigure() MUST then only be called with that
+ *     mode (or SPI_DISABLE). HAL_SPI_API_QUEUE implies master mode.
+ * 
+ *     SPI_SHORT_TRANSFERS (default: undefined) limits the size of
+ *     transfers made by spiTransfer() and its variants, as well as
+ *     queued segments, to 255 bytes, so that spi_isr only deals with
+ *     8-bit counters (SpiIndex, the type of SpiSegment.size, is then
+ *     uint8_t). Has no effect on spiTransferDma().
+ * 
  * **IMPORTANT:** In order to satisfy SDCC's requirements for ISR 
  * handling, this header file **MUST** be included in the C source 
  * file where main() is defined.
  */
 
+#include <gpio-hal.h>
+
 #ifndef SPI_SEGMENT
 	#define SPI_SEGMENT __idata
 #endif
 
+// Type of the transfer sizes handled by spi_isr.
+#ifdef SPI_SHORT_TRANSFERS
+	typedef uint8_t SpiIndex;
+#else
+	typedef size_t SpiIndex;
+#endif // SPI_SHORT_TRANSFERS
+
+#if defined(SPI_MASTER_ONLY) && defined(SPI_SLAVE_ONLY)
+	#error "SPI_MASTER_ONLY and SPI_SLAVE_ONLY are mutually exclusive"
+#endif
+
+#if defined(SPI_SLAVE_ONLY) && defined(HAL_SPI_API_QUEUE)
+	#error "HAL_SPI_API_QUEUE requires master mode"
+#endif
+
+#if defined(SPI_MASTER_ONLY) && defined(HAL_SPI_API_SLAVE_STREAM)
+	#error "HAL_SPI_API_SLAVE_STREAM requires slave mode"
+#endif
+
 /*
  * SPI pin configurations for STC8H
  * 
@@ -171,9 +219,140 @@ typedef enum {
 
 SpiSpeed spiSelectSpeed(uint32_t maxDeviceRate);
 void spiConfigure(SpiMode spiMode, SpiBitOrder bitOrder, SpiPolarity polarity, SpiPhase phase, SpiSpeed speed, uint8_t pinSwitch, GpioPinMode outputPinMode);
+
+/**
+ * Sends bufferSize bytes from tx while receiving as many bytes into rx,
+ * and sets *readyFlag once done. When tx is NULL, SPI_FILL_BYTE is sent
+ * instead. When rx is NULL, received bytes are discarded. tx may point
+ * to __code, and may be the same as rx.
+ */
+void spiTransfer(const uint8_t *tx, uint8_t *rx, size_t bufferSize, bool *readyFlag);
+
+// Both replace buffer's content with received data. spiReceive()
+// sends SPI_FILL_BYTE.
 void spiSend(uint8_t *buffer, size_t bufferSize, bool *readyFlag);
 void spiReceive(uint8_t *buffer, size_t bufferSize, bool *readyFlag);
 
+/**
+ * Same as spiTransfer(), but busy-waits for each byte with the SPI
+ * interrupt disabled, and returns once done. For transfers of a few
+ * bytes, this is much faster than taking an interrupt per byte and
+ * waiting for readyFlag.
+ */
+void spiTransferPolled(const uint8_t *tx, uint8_t *rx, size_t bufferSize);
+
+#ifdef HAL_SPI_API_QUEUE
+	/**
+	 * A device sharing the SPI bus in master mode, with its own chip
+	 * select output (active low) and SPI settings.
+	 */
+	typedef struct {
+		GpioConfig cs; /*!< Chip select output. */
+		uint8_t spctl; /*!< Set by spiDeviceInitialise(). */
+	} SpiDevice;
+	
+	/**
+	 * One part of a transaction, see spiTransfer() for the meaning of
+	 * tx, rx and size. Segments whose size is 0 are skipped.
+	 */
+	typedef struct SpiSegment {
+		const uint8_t *tx;
+		uint8_t *rx;
+		SpiIndex size;
+		struct SpiSegment *next; /*!< Next segment of the job, or NULL. */
+	} SpiSegment;
+	
+	/**
+	 * A transaction: the chained segments are transferred back-to-back
+	 * while the device is selected.
+	 */
+	typedef struct SpiJob {
+		SpiDevice *device;
+		SpiSegment *segments;
+		volatile bool complete; /*!< Set once the device has been deselected. */
+		struct SpiJob *next; /*!< Reserved for the HAL. */
+	} SpiJob;
+	
+	/**
+	 * Configures device->cs, which MUST be set beforehand, and computes
+	 * the device's SPI settings. spiConfigure() MUST still be called
+	 * once with SPI_MASTER to configure the bus itself.
+	 */
+	void spiDeviceInitialise(SpiDevice *device, SpiBitOrder bitOrder, SpiPolarity polarity, SpiPhase phase, SpiSpeed speed);
+	
+	/**
+	 * Queues job and returns immediately. The SPI ISR starts the next
+	 * job as soon as the previous one completes, so the bus doesn't
+	 * idle between devices. Jobs, segments and buffers MUST remain
+	 * untouched until job->complete is set, and spiTransfer() and
+	 * its variants MUST NOT be used while jobs are queued.
+	 */
+	void spiSubmit(SpiJob *job);
+#endif // HAL_SPI_API_QUEUE
+
+#ifdef HAL_SPI_API_SLAVE_STREAM
+	#include <fifo-buffer.h>
+	
+	/**
+	 * Switches spi_isr, which MUST have been configured with SPI_SLAVE,
+	 * to streaming mode: every byte received from the master is written
+	 * to rx, and the reply to the next one is read from tx. When rx is
+	 * full, received bytes are dropped. When tx is empty, SPI_FILL_BYTE
+	 * is sent instead.
+	 * 
+	 * The application writes replies to tx and reads commands from rx
+	 * as with any other FifoState, so transactions may be of any length.
+	 * spiTransfer() and its variants MUST NOT be used until
+	 * spiSlaveStreamStop() is called.
+	 */
+	void spiSlaveStreamStart(FifoState *rx, FifoState *tx);
+	void spiSlaveStreamStop(void);
+	
+	/**
+	 * The SPI peripheral doesn't report SS edges, so the application
+	 * MUST call this function from the ISR watching the SS pin (e.g.
+	 * INT0/INT1, or a port interrupt on STC8G/STC8H) whenever it
+	 * changes. When the slave is selected, the first reply byte is
+	 * loaded before the master starts clocking.
+	 * 
+	 * This function isn't reentrant: it MUST NOT be called from more
+	 * than one ISR.
+	 */
+	void spiSlaveSelectChanged(bool selected);
+	
+	/**
+	 * The following event handlers MUST be implemented. They're called
+	 * from spiSlaveSelectChanged() while streaming.
+	 */
+	
+	// The master has selected us. Reply bytes written to tx from here
+	// are sent in this transaction.
+	void spiOnSlaveFrameStart(void);
+	
+	// The master has deselected us after sending length bytes, some of
+	// which may have been dropped if rx was full.
+	void spiOnSlaveFrameEnd(uint16_t length);
+#endif // HAL_SPI_API_SLAVE_STREAM
+
+#ifdef SPI_USE_DMA
+	#ifndef MCU_HAS_DMA
+		#error "SPI_USE_DMA requires an MCU with DMA"
+	#endif // MCU_HAS_DMA
+	
+	/**
+	 * Sends size bytes from tx while receiving as many bytes into rx,
+	 * and sets *readyFlag once done. rx may be NULL when received data
+	 * doesn't matter, but tx MUST NOT. Both buffers MUST be located in
+	 * __xdata, and remain untouched until *readyFlag is set.
+	 * 
+	 * The SPI interrupt is disabled during the transfer, so spiSend()
+	 * and spiReceive() MUST NOT be called before it completes.
+	 */
+	void spiTransferDma(const __xdata uint8_t *tx, __xdata uint8_t *rx, size_t size, bool *readyFlag);
+	
+	INTERRUPT(spi_dma_isr, DMA_SPI_INTERRUPT);
+#endif // SPI_USE_DMA
+
 INTERRUPT(spi_isr, SPI_INTERRUPT);
 
 #endif // _SPI_HAL_H
@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ * 
+ * Copyright (c) 2023 Vincent DEFERT. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions 
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in the 
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host benchmark comparing FifoState and FifoPow2State on the access
+ * pattern used by the UART ISRs, i.e. one byte at a time.
+ * 
+ * Both sides go through the same out-of-line calls, so that the
+ * difference only reflects the buffer management itself.
+ * 
+ * Absolute figures are those of the host CPU and will differ greatly
+ * from an 8051 core, but the relative cost of the branchy length
+ * computation and compare-and-reset wrapping vs masking remains
+ * meaningful. Results are reported in TSC ticks on x86, and in
+ * nanoseconds elsewhere.
+ * 
+ * Each measurement is repeated, alternating both buffers, and the
+ * minimum is kept: it's the run least disturbed by interrupts and
+ * scheduling on the host.
+ */
+
+#include "project-defs.h"
+#include "fifo-buffer.h"
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define TICK_UNIT "cycles"
+	
+	static uint64_t ticks() {
+		return __rdtsc();
+	}
+#else
+	#define TICK_UNIT "ns"
+	
+	static uint64_t ticks() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		
+		return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+#endif
+
+#define BUFFER_SIZE 64
+#define ROUNDS 20000
+#define REPEATS 25
+// Bytes written then read per round: enough to wrap around regularly.
+#define BURST 48
+
+FIFO_BUFFER(buffer, BUFFER_SIZE, )
+FIFO_BUFFER_POW2(pow2Buffer, BUFFER_SIZE, )
+
+// Prevents the compiler from optimising the benchmark loops away.
+static volatile uint8_t sink;
+
+static double benchFifo() {
+	uint8_t c = 0;
+	uint64_t start = ticks();
+	
+	for (uint32_t round = 0; round < ROUNDS; round++) {
+		for (uint8_t n = 0; n < BURST; n++) {
+			c = n;
+			fifoWrite(&buffer, &c, 1);
+		}
+		
+		for (uint8_t n = 0; n < BURST; n++) {
+			fifoRead(&buffer, &c, 1);
+			sink = c;
+		}
+	}
+	
+	return (double) (ticks() - start) / (ROUNDS * BURST * 2.0);
+}
+
+static double benchPow2() {
+	uint8_t c = 0;
+	uint64_t start = ticks();
+	
+	for (uint32_t round = 0; round < ROUNDS; round++) {
+		for (uint8_t n = 0; n < BURST; n++) {
+			c = n;
+			fifoPow2Write(&pow2Buffer, &c, 1);
+		}
+		
+		for (uint8_t n = 0; n < BURST; n++) {
+			fifoPow2Read(&pow2Buffer, &c, 1);
+			sink = c;
+		}
+	}
+	
+	return (double) (ticks() - start) / (ROUNDS * BURST * 2.0);
+}
+
+int main() {
+	// Warm up caches and branch predictors.
+	benchFifo();
+	benchPow2();
+	
+	double fifo = benchFifo();
+	double pow2 = benchPow2();
+	
+	for (uint8_t n = 1; n < REPEATS; n++) {
+		double value = benchFifo();
+		
+		if (value < fifo) {
+			fifo = value;
+		}
+		
+		value = benchPow2();
+		
+		if (value < pow2) {
+			pow2 = value;
+		}
+	}
+	
+	printf("FifoState     : %6.2f %s/byte\n", fifo, TICK_UNIT);
+	printf("FifoPow2State : %6.2f %s/byte\n", pow2, TICK_UNIT);
+	printf("Saved         : %6.2f %s/byte (%.0f%%)\n", fifo - pow2, TICK_UNIT, 100.0 * (fifo - pow2) / fifo);
+}
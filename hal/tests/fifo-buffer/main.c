@@ -34,12 +34,23 @@
 #include <stdlib.h>
 
 FIFO_BUFFER(buffer, 4, )
+FIFO_BUFFER_POW2(pow2Buffer, 4, )
+FIFO_BUFFER16(buffer16, 4, )
+FIFO_BUFFER16(largeBuffer, 300, )
 
 typedef enum {
 	READ,
 	WRITE,
 } TestType;
 
+typedef enum {
+	FIFO_8,
+	FIFO_POW2,
+	FIFO_16,
+} FifoType;
+
+static const char *fifoNames[] = { "fifo", "pow2", "fifo16" };
+
 typedef struct {
 	TestType test;
 	uint8_t data;
@@ -88,7 +99,7 @@ static const char *test2str(int item) {
 	return result;
 }
 
-int main() {
+static bool runTests(FifoType fifoType) {
 	bool runAllTests = false;
 	bool debug = false;
 	bool allTestsOK = true;
@@ -96,43 +107,183 @@ int main() {
 	for (int item = 0; (allTestsOK || runAllTests) && item < (sizeof(items) / sizeof(TestData)); item++) {
 		uint8_t result = 0;
 		bool retcode = false;
+		uint8_t size = 0;
+		uint16_t rIndex = 0;
+		uint16_t wIndex = 0;
+		
+		switch (fifoType) {
+		case FIFO_8:
+			retcode = (items[item].test == READ)
+				? fifoRead(&buffer, &result, 1)
+				: fifoWrite(&buffer, &items[item].data, 1);
+			size = fifoBytesUsed(&buffer);
+			rIndex = buffer.rIndex;
+			wIndex = buffer.wIndex;
+			break;
 		
-		switch (items[item].test) {
-		case READ:
-			retcode = fifoRead(&buffer, &result, 1);
+		case FIFO_POW2:
+			retcode = (items[item].test == READ)
+				? fifoPow2Read(&pow2Buffer, &result, 1)
+				: fifoPow2Write(&pow2Buffer, &items[item].data, 1);
+			size = fifoPow2Length(&pow2Buffer);
+			rIndex = pow2Buffer.rIndex;
+			wIndex = pow2Buffer.wIndex;
 			break;
 		
-		case WRITE:
-			retcode = fifoWrite(&buffer, &items[item].data, 1);
+		case FIFO_16:
+			retcode = (items[item].test == READ)
+				? fifo16Read(&buffer16, &result, 1)
+				: fifo16Write(&buffer16, &items[item].data, 1);
+			size = fifo16BytesUsed(&buffer16);
+			rIndex = buffer16.rIndex;
+			wIndex = buffer16.wIndex;
 			break;
 		}
 		
-		uint8_t size = fifoBytesUsed(&buffer);
 		bool itemOK = true;
 		
 		if (debug) {
-			printf("After item %2d: .test = %s  .rIndex = %hhd  .wIndex = %hhd  size = %hhd\n", item, test2str(item), buffer.rIndex, buffer.wIndex, size);
+			printf("After item %2d: .test = %s  .rIndex = %hd  .wIndex = %hd  size = %hhd\n", item, test2str(item), rIndex, wIndex, size);
 		}
 		
 		if (retcode != items[item].retcode) {
-			printf("FAILED: item %d, expected retcode = %d, actual %d\n", item, items[item].retcode, retcode);
+			printf("FAILED: %s item %d, expected retcode = %d, actual %d\n", fifoNames[fifoType], item, items[item].retcode, retcode);
 			itemOK = false;
 		}
 		
 		if (itemOK && size != items[item].size) {
-			printf("FAILED: item %d, expected size = %hhd, actual %hhd\n", item, items[item].size, size);
+			printf("FAILED: %s item %d, expected size = %hhd, actual %hhd\n", fifoNames[fifoType], item, items[item].size, size);
 			itemOK = false;
 		}
 		
 		if (itemOK && items[item].test == READ && result != items[item].data) {
-			printf("FAILED: item %d, expected data = %d, actual %d\n", item, items[item].data, result);
+			printf("FAILED: %s item %d, expected data = %d, actual %d\n", fifoNames[fifoType], item, items[item].data, result);
 			itemOK = false;
 		}
 		
 		allTestsOK = allTestsOK && itemOK;
 	}
 	
-	if (allTestsOK) {
+	return allTestsOK;
+}
+
+static bool check(const char *what, int actual, int expected) {
+	if (actual != expected) {
+		printf("FAILED: %s, expected %d, actual %d\n", what, expected, actual);
+	}
+	
+	return actual == expected;
+}
+
+static bool testZeroCopy() {
+	bool ok = true;
+	uint8_t *span;
+	uint8_t value = 0;
+	
+	fifoClear(&buffer);
+	
+	// Empty buffer: 4 usable bytes, all contiguous.
+	ok = check("reserve (empty)", fifoReserve(&buffer, &span), 4) && ok;
+	ok = check("peek (empty)", fifoPeekContiguous(&buffer, &span), 0) && ok;
+	
+	// Write 3 bytes in place, then consume 2 of them.
+	fifoReserve(&buffer, &span);
+	
+	for (uint8_t n = 0; n < 3; n++) {
+		span[n] = 10 + n;
+	}
+	
+	fifoCommit(&buffer, 3);
+	ok = check("length after commit", fifoLength(&buffer), 3) && ok;
+	ok = check("peek after commit", fifoPeekContiguous(&buffer, &span), 3) && ok;
+	ok = check("peeked data", span[0], 10) && ok;
+	fifoConsume(&buffer, 2);
+	ok = check("length after consume", fifoLength(&buffer), 1) && ok;
+	
+	// rIndex = 2, wIndex = 3: free space wraps around, so only the
+	// 2 bytes up to the end of the buffer are contiguous.
+	ok = check("reserve (tail)", fifoReserve(&buffer, &span), 2) && ok;
+	span[0] = 13;
+	span[1] = 14;
+	fifoCommit(&buffer, 2);
+	ok = check("wIndex after wrap", buffer.wIndex, 0) && ok;
+	ok = check("reserve (head)", fifoReserve(&buffer, &span), 1) && ok;
+	span[0] = 15;
+	fifoCommit(&buffer, 1);
+	ok = check("full", fifoIsFull(&buffer), true) && ok;
+	ok = check("reserve (full)", fifoReserve(&buffer, &span), 0) && ok;
+	
+	// Data wraps around: peek returns the part up to the end first.
+	ok = check("peek (tail)", fifoPeekContiguous(&buffer, &span), 3) && ok;
+	ok = check("peeked tail", span[2], 14) && ok;
+	fifoConsume(&buffer, 3);
+	ok = check("rIndex after wrap", buffer.rIndex, 0) && ok;
+	ok = check("peek (head)", fifoPeekContiguous(&buffer, &span), 1) && ok;
+	
+	// Regular reads see the same data.
+	ok = check("read", fifoRead(&buffer, &value, 1), true) && ok;
+	ok = check("read data", value, 15) && ok;
+	ok = check("empty", fifoIsEmpty(&buffer), true) && ok;
+	
+	return ok;
+}
+
+static bool testLargeBuffer() {
+	bool ok = true;
+	uint8_t data[200];
+	uint8_t writeValue = 0;
+	uint8_t readValue = 0;
+	
+	// Keep the buffer partially filled across rounds, so that indexes
+	// wrap past 255 and around the end of the buffer while data is
+	// still pending.
+	for (uint8_t n = 0; n < 100; n++) {
+		data[n] = writeValue++;
+	}
+	
+	ok = check("large preload", fifo16Write(&largeBuffer, data, 100), true) && ok;
+	
+	for (uint8_t round = 0; round < 4; round++) {
+		for (uint8_t n = 0; n < sizeof(data); n++) {
+			data[n] = writeValue++;
+		}
+		
+		ok = check("large write", fifo16Write(&largeBuffer, data, sizeof(data)), true) && ok;
+		ok = check("large full", fifo16IsFull(&largeBuffer), true) && ok;
+		ok = check("large read", fifo16Read(&largeBuffer, data, sizeof(data)), true) && ok;
+		ok = check("large remaining", fifo16Length(&largeBuffer), 100) && ok;
+		
+		for (uint8_t n = 0; n < sizeof(data); n++) {
+			if (data[n] != readValue) {
+				ok = check("large data", data[n], readValue) && ok;
+				break;
+			}
+			
+			readValue++;
+		}
+	}
+	
+	ok = check("large drain", fifo16Read(&largeBuffer, data, 100), true) && ok;
+	ok = check("large empty", fifo16IsEmpty(&largeBuffer), true) && ok;
+	
+	ok = check("large write (1/2)", fifo16Write(&largeBuffer, data, 150), true) && ok;
+	ok = check("large write (2/2)", fifo16Write(&largeBuffer, data, 150), true) && ok;
+	ok = check("large full", fifo16IsFull(&largeBuffer), true) && ok;
+	ok = check("large overflow", fifo16Write(&largeBuffer, data, 1), false) && ok;
+	ok = check("large length", fifo16Length(&largeBuffer), 300) && ok;
+	
+	return ok;
+}
+
+int main() {
+	// All implementations must behave identically with a 4-byte buffer.
+	bool fifoOK = runTests(FIFO_8);
+	bool pow2OK = runTests(FIFO_POW2);
+	bool fifo16OK = runTests(FIFO_16);
+	bool zeroCopyOK = testZeroCopy();
+	bool largeOK = testLargeBuffer();
+	
+	if (fifoOK && pow2OK && fifo16OK && zeroCopyOK && largeOK) {
 		printf("PASSED\n");
 	}
 }
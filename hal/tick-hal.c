@@ -0,0 +1,186 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ * 
+ * Copyright (c) 2023 Vincent DEFERT. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions 
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in the 
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "project-defs.h"
+#include <tick-hal.h>
+
+#ifdef TICK_IDLE_WAIT
+	#include <power-hal.h>
+#endif // TICK_IDLE_WAIT
+
+/**
+ * @file tick-hal.c
+ * 
+ * System tick implementation.
+ */
+
+// Same computations as startTimer(), so that micros() knows how the
+// timer counts.
+#if MCU_FAMILY == 12
+	#define TICK_COUNTER_MAX 256UL
+#else
+	#define TICK_COUNTER_MAX 65536UL
+#endif // MCU_FAMILY == 12
+
+#define TICK_SYSCLK_DIVISOR (MCU_FREQ / (1000UL * TICK_INTERRUPTS_PER_MS))
+
+#if TICK_SYSCLK_DIVISOR > TICK_COUNTER_MAX
+	#define TICK_PERIOD (TICK_SYSCLK_DIVISOR / 12UL)
+#else
+	#define TICK_PERIOD TICK_SYSCLK_DIVISOR
+#endif // TICK_SYSCLK_DIVISOR > TICK_COUNTER_MAX
+
+#if TICK_PERIOD > TICK_COUNTER_MAX
+	#error "Tick period too long for the timer, increase TICK_INTERRUPTS_PER_MS"
+#endif // TICK_PERIOD > TICK_COUNTER_MAX
+
+#define TICK_RELOAD (TICK_COUNTER_MAX - TICK_PERIOD)
+
+// Timer counter, and flag set on overflow until the ISR runs.
+#if TICK_TIMER == 0
+	#define TICK_TIMER_ID TIMER0
+	#define TICK_OVERFLOW (TCON & M_T0IF)
+	
+	#define TICK_COUNTER_L T0L
+	#define TICK_COUNTER_H T0H
+#else
+	#define TICK_TIMER_ID TIMER1
+	#define TICK_OVERFLOW (TCON & M_T1IF)
+	
+	#define TICK_COUNTER_L T1L
+	#define TICK_COUNTER_H T1H
+#endif // TICK_TIMER == 0
+
+static volatile TICK_SEGMENT uint32_t __tickMillis;
+
+#if TICK_INTERRUPTS_PER_MS > 1
+	static volatile TICK_SEGMENT uint8_t __tickFraction;
+#endif // TICK_INTERRUPTS_PER_MS > 1
+
+// Reads the running timer's counter. On STC12, it's the 8-bit T0L/T1L
+// (TxH holds the reload value). Elsewhere, the two bytes are read
+// separately, so TL may roll over in between: TH is read again and
+// the whole read retried when it has changed.
+static INLINE uint16_t __tickReadCounter() {
+#if MCU_FAMILY == 12
+	return TICK_COUNTER_L;
+#else
+	uint8_t high;
+	uint8_t low;
+	
+	do {
+		high = TICK_COUNTER_H;
+		low = TICK_COUNTER_L;
+	} while (high != TICK_COUNTER_H);
+	
+	return ((uint16_t) high << 8) | low;
+#endif // MCU_FAMILY == 12
+}
+
+TimerStatus tickInitialise() {
+	__tickMillis = 0;
+#if TICK_INTERRUPTS_PER_MS > 1
+	__tickFraction = 0;
+#endif // TICK_INTERRUPTS_PER_MS > 1
+	
+	return startTimer(
+		TICK_TIMER_ID,
+		TICK_SYSCLK_DIVISOR,
+		DISABLE_OUTPUT,
+		ENABLE_INTERRUPT,
+		FREE_RUNNING
+	);
+}
+
+INTERRUPT(tick_isr, TICK_INTERRUPT) {
+#if TICK_INTERRUPTS_PER_MS > 1
+	__tickFraction++;
+	
+	if (__tickFraction == TICK_INTERRUPTS_PER_MS) {
+		__tickFraction = 0;
+		__tickMillis++;
+	}
+#else
+	__tickMillis++;
+#endif // TICK_INTERRUPTS_PER_MS > 1
+}
+
+uint32_t millis() {
+	uint32_t result;
+	
+	// The 8051 can't read a 32-bit value atomically.
+	CRITICAL {
+		result = __tickMillis;
+	}
+	
+	return result;
+}
+
+uint32_t micros() {
+	uint32_t ms;
+	uint16_t periods = 0;
+	uint16_t counter;
+	
+	CRITICAL {
+		ms = __tickMillis;
+#if TICK_INTERRUPTS_PER_MS > 1
+		periods = __tickFraction;
+#endif // TICK_INTERRUPTS_PER_MS > 1
+		counter = __tickReadCounter();
+		
+		// When the timer has overflowed but the ISR couldn't run yet,
+		// the counter may have been read before or after its reload.
+		// Reading it again guarantees it's after.
+		if (TICK_OVERFLOW) {
+			counter = __tickReadCounter();
+			periods++;
+		}
+	}
+	
+	uint32_t elapsed = (uint32_t) periods * TICK_PERIOD + (counter - TICK_RELOAD);
+	
+	return ms * 1000UL + elapsed * 1000UL / (TICK_PERIOD * TICK_INTERRUPTS_PER_MS);
+}
+
+void timeoutStart(Timeout *timeout, uint32_t duration) {
+	timeout->start = millis();
+	timeout->duration = duration;
+}
+
+bool timeoutExpired(Timeout *timeout) {
+	return (millis() - timeout->start) >= timeout->duration;
+}
+
+void timeoutWait(Timeout *timeout) {
+	while (!timeoutExpired(timeout)) {
+#ifdef TICK_IDLE_WAIT
+		enterIdleMode();
+#endif // TICK_IDLE_WAIT
+	}
+}
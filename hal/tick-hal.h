@@ -0,0 +1,146 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ * 
+ * Copyright (c) 2023 Vincent DEFERT. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions 
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in the 
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN 
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _TICK_HAL_H
+#define _TICK_HAL_H
+
+/**
+ * @file tick-hal.h
+ * 
+ * System tick definitions: millisecond and microsecond counters, and
+ * non-blocking timeouts.
+ * 
+ * Supported MCU:
+ * 
+ *     STC12*
+ *     STC15*
+ *     STC8*
+ * 
+ * Dependencies:
+ * 
+ *     timer-hal
+ *     power-hal (TICK_IDLE_WAIT only)
+ * 
+ * Optional macros:
+ * 
+ *     TICK_SEGMENT (default: __idata) defines where the tick counters
+ *     will be stored. Impacts ISR execution time.
+ * 
+ *     TICK_TIMER (default: 0) is the timer used, either 0 or 1. It's
+ *     reserved for the tick service.
+ * 
+ *     TICK_INTERRUPTS_PER_MS (default: 1, or 8 on STC12 whose timers
+ *     are 8-bit) is the number of timer interrupts per millisecond. It
+ *     MUST divide 1000, and the timer's period (MCU_FREQ / 1000 /
+ *     TICK_INTERRUPTS_PER_MS) MUST fit the timer. Counters are exact
+ *     when MCU_FREQ is a multiple of 1000 * TICK_INTERRUPTS_PER_MS.
+ * 
+ *     TICK_IDLE_WAIT (default: undefined) makes timeoutWait() put the
+ *     CPU in idle mode between tick interrupts.
+ * 
+ * **IMPORTANT:** In order to satisfy SDCC's requirements for ISR 
+ * handling, this header file **MUST** be included in the C source 
+ * file where main() is defined.
+ */
+
+#include <timer-hal.h>
+
+#ifndef TICK_SEGMENT
+	#define TICK_SEGMENT __idata
+#endif
+
+#ifndef TICK_TIMER
+	#define TICK_TIMER 0
+#endif
+
+#if TICK_TIMER == 0
+	#define TICK_INTERRUPT TIMER0_INTERRUPT
+#elif TICK_TIMER == 1
+	#define TICK_INTERRUPT TIMER1_INTERRUPT
+#else
+	#error "TICK_TIMER MUST be 0 or 1"
+#endif // TICK_TIMER
+
+#ifndef TICK_INTERRUPTS_PER_MS
+	#if MCU_FAMILY == 12
+		#define TICK_INTERRUPTS_PER_MS 8
+	#else
+		#define TICK_INTERRUPTS_PER_MS 1
+	#endif // MCU_FAMILY == 12
+#endif // TICK_INTERRUPTS_PER_MS
+
+/**
+ * Starts the tick timer and its interrupt. Interrupts MUST be enabled
+ * globally (EA = 1) for the counters to run.
+ */
+TimerStatus tickInitialise(void);
+
+/**
+ * Monotonic counters since tickInitialise(). They wrap around after
+ * about 49.7 days and 71.6 minutes respectively, so durations MUST be
+ * computed as differences (see timeoutExpired()).
+ * 
+ * micros() combines the millisecond counter with the timer's own
+ * counter, which takes a 32-bit multiplication and division: prefer
+ * millis() when its resolution is enough.
+ */
+uint32_t millis(void);
+uint32_t micros(void);
+
+/**
+ * Non-blocking timeouts, to replace busy-wait delays with e.g.:
+ * 
+ *     timeoutStart(&timeout, 750);
+ *     // ... then, from the main loop:
+ *     if (timeoutExpired(&timeout)) {
+ *         readTemperature();
+ *     }
+ */
+typedef struct {
+	uint32_t start; /*!< Value of millis() when started. */
+	uint32_t duration; /*!< In milliseconds. */
+} Timeout;
+
+void timeoutStart(Timeout *timeout, uint32_t duration);
+
+/**
+ * Returns true once duration milliseconds have elapsed since
+ * timeoutStart(). Handles the wrap-around of millis().
+ */
+bool timeoutExpired(Timeout *timeout);
+
+/**
+ * Blocks until timeout expires. With TICK_IDLE_WAIT, the CPU sleeps in
+ * idle mode until the next interrupt instead of spinning.
+ */
+void timeoutWait(Timeout *timeout);
+
+INTERRUPT(tick_isr, TICK_INTERRUPT);
+
+#endif // _TICK_HAL_H
@@ -29,18 +29,20 @@
  */
 #include "project-defs.h"
 #include <uart-hal.h>
+#include <string.h>
 
 #ifndef UART_DEFAULT_BUFFER_SIZE
 	#define UART_DEFAULT_BUFFER_SIZE 16
 #endif
 
 #ifndef UART_DEFAULT_SEGMENT
-	#if HAL_UARTS > 1
+	#if HAL_UARTS > 1 || defined(UART_DMA_MODE)
 		// __data and __idata are too small to be used as default values:
 		// default values should "just work", even when using all UART
 		// simultaneously.
 		// __xdata uses more flash but takes 1 cycle less than __pdata,
-		// that seems a good trade off.
+		// that seems a good trade off. It's also the only segment DMA
+		// can access.
 		#define UART_DEFAULT_SEGMENT __xdata
 	#else
 		// With just one UART, __idata is a sound default, especially
@@ -53,8 +55,6 @@
  * @file uart-hal.c
  * 
  * UART abstraction layer implementation for STC12, STC15 and STC8.
- * 
- * TODO: 9-bit modes (parity & multi-machine) support.
  */
 
 #define STATUS_CLEAR   0
@@ -72,8 +72,9 @@
 	#define UART1_SEGMENT UART_DEFAULT_SEGMENT
 #endif
 
-FIFO_BUFFER(UART1_receiveBuffer, UART1_RX_BUFFER_SIZE, UART1_SEGMENT)
-FIFO_BUFFER(UART1_transmitBuffer, UART1_TX_BUFFER_SIZE, UART1_SEGMENT)
+#if UART1_TX_BUFFER_SIZE > 255 || UART1_RX_BUFFER_SIZE > 255
+	#define UART_NEEDS_FIFO16
+#endif
 
 #if HAL_UARTS >= 2
 	#ifndef UART2_TX_BUFFER_SIZE
@@ -88,8 +89,9 @@ FIFO_BUFFER(UART1_transmitBuffer, UART1_TX_BUFFER_SIZE, UART1_SEGMENT)
 		#define UART2_SEGMENT UART_DEFAULT_SEGMENT
 	#endif
 
-	FIFO_BUFFER(UART2_receiveBuffer, UART2_RX_BUFFER_SIZE, UART2_SEGMENT)
-	FIFO_BUFFER(UART2_transmitBuffer, UART2_TX_BUFFER_SIZE, UART2_SEGMENT)
+	#if UART2_TX_BUFFER_SIZE > 255 || UART2_RX_BUFFER_SIZE > 255
+		#define UART_NEEDS_FIFO16
+	#endif
 #endif // HAL_UARTS >= 2
 
 #if HAL_UARTS >= 3
@@ -105,9 +107,6 @@ FIFO_BUFFER(UART1_transmitBuffer, UART1_TX_BUFFER_SIZE, UART1_SEGMENT)
 		#define UART3_SEGMENT UART_DEFAULT_SEGMENT
 	#endif
 
-	FIFO_BUFFER(UART3_receiveBuffer, UART3_RX_BUFFER_SIZE, UART3_SEGMENT)
-	FIFO_BUFFER(UART3_transmitBuffer, UART3_TX_BUFFER_SIZE, UART3_SEGMENT)
-
 	#ifndef UART4_TX_BUFFER_SIZE
 		#define UART4_TX_BUFFER_SIZE UART_DEFAULT_BUFFER_SIZE
 	#endif
@@ -120,74 +119,685 @@ FIFO_BUFFER(UART1_transmitBuffer, UART1_TX_BUFFER_SIZE, UART1_SEGMENT)
 		#define UART4_SEGMENT UART_DEFAULT_SEGMENT
 	#endif
 
-	FIFO_BUFFER(UART4_receiveBuffer, UART4_RX_BUFFER_SIZE, UART4_SEGMENT)
-	FIFO_BUFFER(UART4_transmitBuffer, UART4_TX_BUFFER_SIZE, UART4_SEGMENT)
+	#if UART3_TX_BUFFER_SIZE > 255 || UART3_RX_BUFFER_SIZE > 255 \
+		|| UART4_TX_BUFFER_SIZE > 255 || UART4_RX_BUFFER_SIZE > 255
+		#define UART_NEEDS_FIFO16
+	#endif
 #endif // HAL_UARTS >= 3
 
-static FifoState *uartReceiveBuffer(Uart uart) {
-	FifoState *result = NULL;
+/*
+ * All UARTs share the same FIFO implementation, so that the functions
+ * below can handle any of them. As soon as one buffer is larger than
+ * 255 bytes, the 16-bit variant is used for all of them.
+ */
+#ifdef UART_NEEDS_FIFO16
+	typedef FifoState16 UartFifo;
 	
-	switch (uart) {
-	case UART1:
-		result = &UART1_receiveBuffer;
-		break;
+	typedef uint16_t UartFifoSize;
 	
+	#define UART_FIFO_BUFFER FIFO_BUFFER16
+	#define uartFifoWrite fifo16Write
+	#define uartFifoRead fifo16Read
+	#define uartFifoBytesFree fifo16BytesFree
+	#define uartFifoLength fifo16Length
+	#define uartFifoReserve fifo16Reserve
+	#define uartFifoCommit fifo16Commit
+	#define uartFifoPeekContiguous fifo16PeekContiguous
+	#define uartFifoConsume fifo16Consume
+#else
+	typedef FifoState UartFifo;
+	typedef uint8_t UartFifoSize;
+	
+	#define UART_FIFO_BUFFER FIFO_BUFFER
+	#define uartFifoWrite fifoWrite
+	#define uartFifoRead fifoRead
+	#define uartFifoBytesFree fifoBytesFree
+	#define uartFifoLength fifoLength
+	#define uartFifoReserve fifoReserve
+	#define uartFifoCommit fifoCommit
+	#define uartFifoPeekContiguous fifoPeekContiguous
+	#define uartFifoConsume fifoConsume
+#endif // UART_NEEDS_FIFO16
+
+UART_FIFO_BUFFER(UART1_receiveBuffer, UART1_RX_BUFFER_SIZE, UART1_SEGMENT)
+UART_FIFO_BUFFER(UART1_transmitBuffer, UART1_TX_BUFFER_SIZE, UART1_SEGMENT)
+
 #if HAL_UARTS >= 2
-	case UART2:
-		result = &UART2_receiveBuffer;
-		break;
+	UART_FIFO_BUFFER(UART2_receiveBuffer, UART2_RX_BUFFER_SIZE, UART2_SEGMENT)
+	UART_FIFO_BUFFER(UART2_transmitBuffer, UART2_TX_BUFFER_SIZE, UART2_SEGMENT)
 #endif // HAL_UARTS >= 2
 
 #if HAL_UARTS >= 3
-	case UART3:
-		result = &UART3_receiveBuffer;
-		break;
-	
-	case UART4:
-		result = &UART4_receiveBuffer;
-		break;
+	UART_FIFO_BUFFER(UART3_receiveBuffer, UART3_RX_BUFFER_SIZE, UART3_SEGMENT)
+	UART_FIFO_BUFFER(UART3_transmitBuffer, UART3_TX_BUFFER_SIZE, UART3_SEGMENT)
+	UART_FIFO_BUFFER(UART4_receiveBuffer, UART4_RX_BUFFER_SIZE, UART4_SEGMENT)
+	UART_FIFO_BUFFER(UART4_transmitBuffer, UART4_TX_BUFFER_SIZE, UART4_SEGMENT)
 #endif // HAL_UARTS >= 3
+
+#ifdef UART_STATISTICS
+	static UART1_SEGMENT UartStatistics UART1_statistics;
+	
+	#if HAL_UARTS >= 2
+		static UART2_SEGMENT UartStatistics UART2_statistics;
+	#endif // HAL_UARTS >= 2
+	
+	#if HAL_UARTS >= 3
+		static UART3_SEGMENT UartStatistics UART3_statistics;
+		static UART4_SEGMENT UartStatistics UART4_statistics;
+	#endif // HAL_UARTS >= 3
+	
+	// Called by the RX ISR once a byte has been stored.
+	#define UART_COUNT_RECEIVED(statistics, buffer) do { \
+		UartFifoSize used = uartFifoLength(&(buffer)); \
+		(statistics).rxBytes++; \
+		\
+		if (used > (statistics).rxHighWaterMark) { \
+			(statistics).rxHighWaterMark = used; \
+		} \
+	} while (0)
+#endif // UART_STATISTICS
+
+#ifdef UART_FRAME_MODE
+	typedef struct {
+		uint16_t length; /*!< Bytes received since the previous frame. */
+		uint8_t ticksLeft; /*!< Ticks until end of frame, 0 when idle. */
+	} UartFrameState;
+	
+	#ifdef UART1_FRAME_TIMEOUT
+		static UART1_SEGMENT UartFrameState UART1_frameState;
+	#endif // UART1_FRAME_TIMEOUT
+	
+	#if HAL_UARTS >= 2 && defined(UART2_FRAME_TIMEOUT)
+		static UART2_SEGMENT UartFrameState UART2_frameState;
+	#endif // HAL_UARTS >= 2 && defined(UART2_FRAME_TIMEOUT)
+	
+	#if HAL_UARTS >= 3 && defined(UART3_FRAME_TIMEOUT)
+		static UART3_SEGMENT UartFrameState UART3_frameState;
+	#endif // HAL_UARTS >= 3 && defined(UART3_FRAME_TIMEOUT)
+	
+	#if HAL_UARTS >= 3 && defined(UART4_FRAME_TIMEOUT)
+		static UART4_SEGMENT UartFrameState UART4_frameState;
+	#endif // HAL_UARTS >= 3 && defined(UART4_FRAME_TIMEOUT)
+	
+	static void __uartFrameTick(Uart uart, UartFrameState *state) {
+		if (state->ticksLeft) {
+			state->ticksLeft--;
+			
+			if (state->ticksLeft == 0) {
+				uint16_t length = state->length;
+				state->length = 0;
+				uartOnFrameReceived(uart, length);
+			}
+		}
 	}
 	
-	return result;
-}
+	void uartFrameTimerTick() {
+	#ifdef UART1_FRAME_TIMEOUT
+		__uartFrameTick(UART1, &UART1_frameState);
+	#endif // UART1_FRAME_TIMEOUT
+	
+	#if HAL_UARTS >= 2 && defined(UART2_FRAME_TIMEOUT)
+		__uartFrameTick(UART2, &UART2_frameState);
+	#endif // HAL_UARTS >= 2 && defined(UART2_FRAME_TIMEOUT)
+	
+	#if HAL_UARTS >= 3 && defined(UART3_FRAME_TIMEOUT)
+		__uartFrameTick(UART3, &UART3_frameState);
+	#endif // HAL_UARTS >= 3 && defined(UART3_FRAME_TIMEOUT)
+	
+	#if HAL_UARTS >= 3 && defined(UART4_FRAME_TIMEOUT)
+		__uartFrameTick(UART4, &UART4_frameState);
+	#endif // HAL_UARTS >= 3 && defined(UART4_FRAME_TIMEOUT)
+	}
+	
+	TimerStatus uartStartFrameTimer(Timer timer, uint32_t baudRate) {
+		// One character is 10 bits long: start, 8 data and stop bits.
+		return startTimer(
+			timer, 
+			frequencyToSysclkDivisor(baudRate / 10UL), 
+			DISABLE_OUTPUT, 
+			ENABLE_INTERRUPT, 
+			FREE_RUNNING
+		);
+	}
+#endif // UART_FRAME_MODE
 
-static FifoState *uartTransmitBuffer(Uart uart) {
-	FifoState *result = NULL;
+#ifdef UART_DMA_MODE
+	// DMA_URxx_AMT holds the number of bytes to transfer minus 1, so
+	// 256 is possible, but we keep transfer sizes within a uint8_t.
+	#define UART_DMA_MAX_TRANSFER 255
 	
-	switch (uart) {
-	case UART1:
-		result = &UART1_transmitBuffer;
-		break;
+	typedef struct {
+		const __xdata uint8_t *block; /*!< Block passed to uartSendBlockDma(). */
+		uint16_t blockSize; /*!< Bytes of the block not sent yet. */
+		uint8_t txCount; /*!< Size of the transmit transfer in progress. */
+		bool sendingBlock; /*!< Whether that transfer comes from block or the FIFO. */
+		uint8_t rxCount; /*!< Size of the receive transfer in progress. */
+		uint8_t rxCommitted; /*!< Bytes of it already committed to the FIFO. */
+	} UartDmaState;
+	
+	#ifdef UART1_USE_DMA
+		static UART1_SEGMENT UartDmaState UART1_dmaState;
+	#endif // UART1_USE_DMA
 	
+	#if HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+		static UART2_SEGMENT UartDmaState UART2_dmaState;
+	#endif // HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+		static UART3_SEGMENT UartDmaState UART3_dmaState;
+	#endif // HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		static UART4_SEGMENT UartDmaState UART4_dmaState;
+	#endif // HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+#endif // UART_DMA_MODE
+
+/*
+ * The UART's mode is kept in its receive buffer's status byte, which
+ * is otherwise unused.
+ */
+#define uartMode(buffer) ((buffer).status)
+
+// Returns the value of the 9th bit for c in mode UART_8E1 or UART_8O1.
+static INLINE bool uartParityBit(uint8_t c, uint8_t mode) {
+	bool parity;
+	
+	// PSW.P is set when ACC holds an odd number of 1s.
+	ACC = c;
+	parity = P;
+	
+	return (mode == UART_8O1) ? !parity : parity;
+}
+
+/*
+ * Matches c against the given address (address & mask) and the
+ * broadcast address (address | mask), where bits cleared in mask are
+ * "don't care". This mimics UART1's automatic address recognition.
+ */
+static INLINE bool uartAddressMatches(uint8_t c, uint8_t address, uint8_t mask) {
+	uint8_t broadcast = address | mask;
+	
+	return ((c ^ address) & mask) == 0 || (c & broadcast) == broadcast;
+}
+
+// In 9-bit modes, TB8 holds the parity bit, or 0 for a data byte.
+#define UART_WRITE_BUFFER(scon, sbuf, mode, c) do { \
+	if ((mode) != UART_8N1) { \
+		if ((mode) != UART_MULTI_MACHINE && uartParityBit(c, mode)) { \
+			scon |= M_TB8; \
+		} else { \
+			scon &= ~M_TB8; \
+		} \
+	} \
+	sbuf = (c); \
+} while (0)
+
+#define UART1_WRITE_BUFFER(c) UART_WRITE_BUFFER(S1CON, S1BUF, uartMode(UART1_receiveBuffer), c)
+#define UART2_WRITE_BUFFER(c) UART_WRITE_BUFFER(S2CON, S2BUF, uartMode(UART2_receiveBuffer), c)
+#define UART3_WRITE_BUFFER(c) UART_WRITE_BUFFER(S3CON, S3BUF, uartMode(UART3_receiveBuffer), c)
+#define UART4_WRITE_BUFFER(c) UART_WRITE_BUFFER(S4CON, S4BUF, uartMode(UART4_receiveBuffer), c)
+
 #if HAL_UARTS >= 2
-	case UART2:
-		result = &UART2_transmitBuffer;
-		break;
+	/*
+	 * Only UART1 has hardware address recognition (SADDR and SADEN),
+	 * the other UARTs match address bytes in their ISR.
+	 */
+	typedef struct {
+		uint8_t address; /*!< Given address, as in SADDR. */
+		uint8_t mask; /*!< Address mask, as in SADEN. */
+	} UartAddress;
+	
+	static UART2_SEGMENT UartAddress UART2_address;
+	
+	#if HAL_UARTS >= 3
+		static UART3_SEGMENT UartAddress UART3_address;
+		static UART4_SEGMENT UartAddress UART4_address;
+	#endif // HAL_UARTS >= 3
 #endif // HAL_UARTS >= 2
 
-#if HAL_UARTS >= 3
-	case UART3:
-		result = &UART3_transmitBuffer;
-		break;
+#ifdef HAL_UART_API_TRANSMIT_QUEUE
+	typedef struct {
+		UartTransmitDescriptor *head; /*!< Descriptor being sent. */
+		UartTransmitDescriptor *tail; /*!< Last queued descriptor. */
+	} UartTransmitQueue;
 	
-	case UART4:
-		result = &UART4_transmitBuffer;
-		break;
-#endif // HAL_UARTS >= 3
+	static UART1_SEGMENT UartTransmitQueue UART1_transmitQueue;
+	
+	#if HAL_UARTS >= 2
+		static UART2_SEGMENT UartTransmitQueue UART2_transmitQueue;
+	#endif // HAL_UARTS >= 2
+	
+	#if HAL_UARTS >= 3
+		static UART3_SEGMENT UartTransmitQueue UART3_transmitQueue;
+		static UART4_SEGMENT UartTransmitQueue UART4_transmitQueue;
+	#endif // HAL_UARTS >= 3
+	
+	/*
+	 * Fetches the next byte of the queued descriptors, and releases
+	 * the head descriptor once it has been sent entirely. Returns false
+	 * when the queue is empty.
+	 */
+	static INLINE bool uartQueueReadByte(UartTransmitQueue *queue, uint8_t *c) {
+		UartTransmitDescriptor *descriptor = queue->head;
+		bool rc = false;
+		
+		if (descriptor) {
+			*c = *descriptor->data++;
+			descriptor->size--;
+			rc = true;
+			
+			if (descriptor->size == 0) {
+				queue->head = descriptor->next;
+				descriptor->complete = true;
+			}
+		}
+		
+		return rc;
+	}
+#endif // HAL_UART_API_TRANSMIT_QUEUE
+
+#ifdef UART1_USE_DMA
+	#define UART1_DMA_STATE (&UART1_dmaState)
+#else
+	#define UART1_DMA_STATE NULL
+#endif // UART1_USE_DMA
+
+#ifdef UART2_USE_DMA
+	#define UART2_DMA_STATE (&UART2_dmaState)
+#else
+	#define UART2_DMA_STATE NULL
+#endif // UART2_USE_DMA
+
+#ifdef UART3_USE_DMA
+	#define UART3_DMA_STATE (&UART3_dmaState)
+#else
+	#define UART3_DMA_STATE NULL
+#endif // UART3_USE_DMA
+
+#ifdef UART4_USE_DMA
+	#define UART4_DMA_STATE (&UART4_dmaState)
+#else
+	#define UART4_DMA_STATE NULL
+#endif // UART4_USE_DMA
+
+#if HAL_UARTS == 1
+	/*
+	 * Single-UART builds: everything resolves to UART1 at compile time,
+	 * so there's neither a table lookup nor a switch. Referencing uart
+	 * keeps SDCC from complaining about unreferenced arguments.
+	 */
+	#define uartReceiveBuffer(uart) ((void) (uart), &UART1_receiveBuffer)
+	#define uartTransmitBuffer(uart) ((void) (uart), &UART1_transmitBuffer)
+	#define uartWriteBuffer(uart, c) do { (void) (uart); UART1_WRITE_BUFFER(c); } while (0)
+	#define uartDmaState(uart) ((void) (uart), UART1_DMA_STATE)
+	#define uartTransmitQueue(uart) ((void) (uart), &UART1_transmitQueue)
+	#define uartStatistics(uart) ((void) (uart), &UART1_statistics)
+#else
+	/*
+	 * The per-UART data needed on the send and receive paths is looked
+	 * up in a table located in code space, indexed by uart - 1, instead
+	 * of going through a switch on each call. SxBUF can't be accessed
+	 * indirectly, hence the thunks.
+	 */
+	typedef struct {
+		UartFifo *receiveBuffer;
+		UartFifo *transmitBuffer;
+	#ifdef UART_DMA_MODE
+		UartDmaState *dmaState; /*!< NULL when the UART doesn't use DMA. */
+	#endif // UART_DMA_MODE
+	#ifdef HAL_UART_API_TRANSMIT_QUEUE
+		UartTransmitQueue *transmitQueue;
+	#endif // HAL_UART_API_TRANSMIT_QUEUE
+	#ifdef UART_STATISTICS
+		UartStatistics *statistics;
+	#endif // UART_STATISTICS
+		void (*writeBuffer)(uint8_t c); /*!< Writes c to SxBUF. */
+	} UartDescriptor;
+	
+	static void __uart1WriteBuffer(uint8_t c) {
+		UART1_WRITE_BUFFER(c);
 	}
 	
-	return result;
-}
+	static void __uart2WriteBuffer(uint8_t c) {
+		UART2_WRITE_BUFFER(c);
+	}
+	
+	#if HAL_UARTS >= 3
+		static void __uart3WriteBuffer(uint8_t c) {
+			UART3_WRITE_BUFFER(c);
+		}
+		
+		static void __uart4WriteBuffer(uint8_t c) {
+			UART4_WRITE_BUFFER(c);
+		}
+	#endif // HAL_UARTS >= 3
+	
+	#ifdef UART_DMA_MODE
+		#define UART_DESCRIPTOR_DMA(n) .dmaState = UART ## n ## _DMA_STATE,
+	#else
+		#define UART_DESCRIPTOR_DMA(n)
+	#endif // UART_DMA_MODE
+	
+	#ifdef HAL_UART_API_TRANSMIT_QUEUE
+		#define UART_DESCRIPTOR_QUEUE(n) .transmitQueue = &UART ## n ## _transmitQueue,
+	#else
+		#define UART_DESCRIPTOR_QUEUE(n)
+	#endif // HAL_UART_API_TRANSMIT_QUEUE
+	
+	#ifdef UART_STATISTICS
+		#define UART_DESCRIPTOR_STATISTICS(n) .statistics = &UART ## n ## _statistics,
+	#else
+		#define UART_DESCRIPTOR_STATISTICS(n)
+	#endif // UART_STATISTICS
+	
+	#define UART_DESCRIPTOR(n) { \
+		.receiveBuffer = &UART ## n ## _receiveBuffer, \
+		.transmitBuffer = &UART ## n ## _transmitBuffer, \
+		UART_DESCRIPTOR_DMA(n) \
+		UART_DESCRIPTOR_QUEUE(n) \
+		UART_DESCRIPTOR_STATISTICS(n) \
+		.writeBuffer = __uart ## n ## WriteBuffer, \
+	}
+	
+	static const UartDescriptor __code uartDescriptors[] = {
+		UART_DESCRIPTOR(1),
+		UART_DESCRIPTOR(2),
+	#if HAL_UARTS >= 3
+		UART_DESCRIPTOR(3),
+		UART_DESCRIPTOR(4),
+	#endif // HAL_UARTS >= 3
+	};
+	
+	#define uartDescriptor(uart) (&uartDescriptors[(uart) - 1])
+	#define uartReceiveBuffer(uart) (uartDescriptor(uart)->receiveBuffer)
+	#define uartTransmitBuffer(uart) (uartDescriptor(uart)->transmitBuffer)
+	#define uartWriteBuffer(uart, c) (uartDescriptor(uart)->writeBuffer(c))
+	#define uartDmaState(uart) (uartDescriptor(uart)->dmaState)
+	#define uartTransmitQueue(uart) (uartDescriptor(uart)->transmitQueue)
+	#define uartStatistics(uart) (uartDescriptor(uart)->statistics)
+#endif // HAL_UARTS == 1
+
+#ifdef UART_DMA_MODE
+	static void __uartDmaStartTransmit(Uart uart, uint16_t address, uint8_t count) {
+		switch (uart) {
+	#ifdef UART1_USE_DMA
+		case UART1:
+			DMA_UR1T_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR1T_STA = 0;
+			DMA_UR1T_AMT = count - 1;
+			DMA_UR1T_TXAH = address >> 8;
+			DMA_UR1T_TXAL = address;
+			DMA_UR1T_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_TX;
+			break;
+	#endif // UART1_USE_DMA
+	
+	#if HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+		case UART2:
+			DMA_UR2T_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR2T_STA = 0;
+			DMA_UR2T_AMT = count - 1;
+			DMA_UR2T_TXAH = address >> 8;
+			DMA_UR2T_TXAL = address;
+			DMA_UR2T_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_TX;
+			break;
+	#endif // HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+		case UART3:
+			DMA_UR3T_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR3T_STA = 0;
+			DMA_UR3T_AMT = count - 1;
+			DMA_UR3T_TXAH = address >> 8;
+			DMA_UR3T_TXAL = address;
+			DMA_UR3T_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_TX;
+			break;
+	#endif // HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		case UART4:
+			DMA_UR4T_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR4T_STA = 0;
+			DMA_UR4T_AMT = count - 1;
+			DMA_UR4T_TXAH = address >> 8;
+			DMA_UR4T_TXAL = address;
+			DMA_UR4T_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_TX;
+			break;
+	#endif // HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		}
+	}
+	
+	static void __uartDmaStartReceive(Uart uart, uint16_t address, uint8_t count) {
+		switch (uart) {
+	#ifdef UART1_USE_DMA
+		case UART1:
+			DMA_UR1R_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR1R_STA = 0;
+			DMA_UR1R_AMT = count - 1;
+			DMA_UR1R_RXAH = address >> 8;
+			DMA_UR1R_RXAL = address;
+			DMA_UR1R_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_RX;
+			break;
+	#endif // UART1_USE_DMA
+	
+	#if HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+		case UART2:
+			DMA_UR2R_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR2R_STA = 0;
+			DMA_UR2R_AMT = count - 1;
+			DMA_UR2R_RXAH = address >> 8;
+			DMA_UR2R_RXAL = address;
+			DMA_UR2R_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_RX;
+			break;
+	#endif // HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+		case UART3:
+			DMA_UR3R_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR3R_STA = 0;
+			DMA_UR3R_AMT = count - 1;
+			DMA_UR3R_RXAH = address >> 8;
+			DMA_UR3R_RXAL = address;
+			DMA_UR3R_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_RX;
+			break;
+	#endif // HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		case UART4:
+			DMA_UR4R_CFG = M_DMA_INTERRUPT_ENABLE;
+			DMA_UR4R_STA = 0;
+			DMA_UR4R_AMT = count - 1;
+			DMA_UR4R_RXAH = address >> 8;
+			DMA_UR4R_RXAL = address;
+			DMA_UR4R_CR = M_DMA_CHANNEL_ENABLE | M_TRIG_RX;
+			break;
+	#endif // HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		}
+	}
+	
+	static uint8_t __uartDmaBytesReceived(Uart uart) {
+		uint8_t result = 0;
+		
+		switch (uart) {
+	#ifdef UART1_USE_DMA
+		case UART1:
+			result = DMA_UR1R_DONE;
+			break;
+	#endif // UART1_USE_DMA
+	
+	#if HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+		case UART2:
+			result = DMA_UR2R_DONE;
+			break;
+	#endif // HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+		case UART3:
+			result = DMA_UR3R_DONE;
+			break;
+	#endif // HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+	
+	#if HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		case UART4:
+			result = DMA_UR4R_DONE;
+			break;
+	#endif // HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+		}
+		
+		return result;
+	}
+	
+	/*
+	 * The functions below are called both from the DMA ISR and from
+	 * the main loop. In the latter case, they MUST be called with
+	 * interrupts disabled.
+	 */
+	
+	// Starts the next transmit transfer: pending block first, then
+	// the contents of the transmit FIFO.
+	static void __uartDmaSendNext(Uart uart, UartFifo *buffer, UartDmaState *state) {
+		uint8_t *data;
+		UartFifoSize count;
+		
+		state->sendingBlock = (state->blockSize != 0);
+		
+		if (state->sendingBlock) {
+			data = (uint8_t *) state->block;
+			count = (state->blockSize > UART_DMA_MAX_TRANSFER) ? UART_DMA_MAX_TRANSFER : state->blockSize;
+		} else {
+			count = uartFifoPeekContiguous(buffer, &data);
+			
+			if (count > UART_DMA_MAX_TRANSFER) {
+				count = UART_DMA_MAX_TRANSFER;
+			}
+		}
+		
+		state->txCount = count;
+		
+		if (count) {
+			buffer->status = STATUS_SENDING;
+			__uartDmaStartTransmit(uart, (uint16_t) data, count);
+		} else {
+			buffer->status = STATUS_CLEAR;
+		}
+	}
+	
+	static void __uartDmaOnTransmitComplete(Uart uart, UartFifo *buffer, UartDmaState *state) {
+	#ifdef UART_STATISTICS
+		uartStatistics(uart)->txBytes += state->txCount;
+	#endif // UART_STATISTICS
+		
+		// A block may have been queued while a FIFO transfer was in
+		// progress, so blockSize doesn't tell what has just been sent.
+		if (state->sendingBlock) {
+			state->block += state->txCount;
+			state->blockSize -= state->txCount;
+			
+			if (state->blockSize == 0) {
+				uartOnDmaTransmitComplete(uart);
+			}
+		} else {
+			uartFifoConsume(buffer, state->txCount);
+		}
+		
+		__uartDmaSendNext(uart, buffer, state);
+	}
+	
+	// Starts the next receive transfer on the largest contiguous free
+	// span of the receive FIFO. When the FIFO is full, reception stays
+	// suspended until __uartDmaSyncReceive() finds free space.
+	static void __uartDmaReceiveNext(Uart uart, UartFifo *buffer, UartDmaState *state) {
+		uint8_t *data;
+		UartFifoSize count = uartFifoReserve(buffer, &data);
+		
+		if (count > UART_DMA_MAX_TRANSFER) {
+			count = UART_DMA_MAX_TRANSFER;
+		}
+		
+		state->rxCount = count;
+		state->rxCommitted = 0;
+		
+		if (count) {
+			__uartDmaStartReceive(uart, (uint16_t) data, count);
+		}
+	}
+	
+	static void __uartDmaCommit(Uart uart, UartFifo *buffer, uint8_t count) {
+		uartFifoCommit(buffer, count);
+		
+	#ifdef UART_STATISTICS
+		UartStatistics *statistics = uartStatistics(uart);
+		UartFifoSize used = uartFifoLength(buffer);
+		statistics->rxBytes += count;
+		
+		if (used > statistics->rxHighWaterMark) {
+			statistics->rxHighWaterMark = used;
+		}
+	#endif // UART_STATISTICS
+	}
+	
+	static void __uartDmaOnReceiveComplete(Uart uart, UartFifo *buffer, UartDmaState *state) {
+		uint8_t count = state->rxCount - state->rxCommitted;
+		__uartDmaCommit(uart, buffer, count);
+		__uartDmaReceiveNext(uart, buffer, state);
+		
+		// The main loop may already have committed every byte.
+		if (count) {
+			uartOnDmaDataReceived(uart, count);
+		}
+	}
+	
+	// Publishes bytes received by the transfer in progress, or resumes
+	// reception if it was suspended.
+	static void __uartDmaSyncReceive(Uart uart, UartFifo *buffer, UartDmaState *state) {
+		if (state->rxCount) {
+			uint8_t done = __uartDmaBytesReceived(uart);
+			
+			if (done > state->rxCommitted) {
+				__uartDmaCommit(uart, buffer, done - state->rxCommitted);
+				state->rxCommitted = done;
+			}
+		} else {
+			__uartDmaReceiveNext(uart, buffer, state);
+		}
+	}
+	
+	bool uartSendBlockDma(Uart uart, const __xdata uint8_t *data, uint16_t size, BlockingOperation blocking) {
+		UartDmaState *state = uartDmaState(uart);
+		UartFifo *buffer = uartTransmitBuffer(uart);
+		bool rc = false;
+		
+		if (size == 0) {
+			// Nothing to wait for.
+			uartOnDmaTransmitComplete(uart);
+			return true;
+		}
+		
+		do {
+			CRITICAL {
+				if (state->blockSize == 0) {
+					state->block = data;
+					state->blockSize = size;
+					rc = true;
+					
+					if (buffer->status == STATUS_CLEAR) {
+						__uartDmaSendNext(uart, buffer, state);
+					}
+				}
+			}
+		} while (!rc && blocking == BLOCKING);
+		
+		return rc;
+	}
+#endif // UART_DMA_MODE
 
 bool uartIsTransmissionComplete(Uart uart) {
-	FifoState *buffer = uartTransmitBuffer(uart);
+	UartFifo *buffer = uartTransmitBuffer(uart);
 	
 	return buffer->status == STATUS_CLEAR;
 }
 
 bool uartTransmitBufferHasBytesFree(Uart uart, uint8_t bytes) {
-	return fifoBytesFree(uartTransmitBuffer(uart)) >= bytes;
+	return uartFifoBytesFree(uartTransmitBuffer(uart)) >= bytes;
 }
 
 #if !defined(M_S1_S) || !defined(TIMER_HAS_T1) || !defined(TIMER_HAS_T2)
@@ -260,7 +870,8 @@ TimerStatus uartInitialise(Uart uart, uint32_t baudRate, UartBaudRateTimer baudR
 			if (uart == UART1) {
 				operationMode = 2 | ((baudRate & 2) >> 1);
 			} else {
-				operationMode = 1;
+				// 9-bit mode is selected by SxSM0.
+				operationMode = 2;
 			}
 			break;
 		}
@@ -307,10 +918,18 @@ TimerStatus uartInitialise(Uart uart, uint32_t baudRate, UartBaudRateTimer baudR
 #endif // M_S1_S
 			
 			// Set UART mode and clear interrupt flag
+			PCON &= ~M_SMOD0;
 			S1CON = scon | ((operationMode & 1) ? M_SM1 : 0);
 			
+#ifdef UART_STATISTICS
+			// Make SM0 read as FE, to detect framing errors.
+			PCON |= M_SMOD0;
+#endif // UART_STATISTICS
+			
+#ifndef UART1_USE_DMA
 			// Enable serial port interrupt
 			IE1 |= M_ES1;
+#endif // UART1_USE_DMA
 			break;
 		
 #if HAL_UARTS >= 2
@@ -333,8 +952,10 @@ TimerStatus uartInitialise(Uart uart, uint32_t baudRate, UartBaudRateTimer baudR
 			S2CON = scon | M_SM1; // Yes, that's not a mistake, see TRM.
 	#endif // MCU_FAMILY == 12
 			
+	#ifndef UART2_USE_DMA
 			// Enable serial port interrupt
 			IE2 |= M_ES2;
+	#endif // UART2_USE_DMA
 			break;
 #endif // HAL_UARTS >= 2
 
@@ -350,11 +971,14 @@ TimerStatus uartInitialise(Uart uart, uint32_t baudRate, UartBaudRateTimer baudR
 			// Set pin configuration
 			P_SW2 = (P_SW2 & ~M_S3_S) | ((pinSwitch << P_S3_S) & M_S3_S);
 			
-			// Set UART mode and clear interrupt flag
-			S3CON = scon;
+			// Set UART mode and clear interrupt flag, keeping the
+			// clock source configured above.
+			S3CON = scon | (S3CON & M_S3ST3);
 			
+	#ifndef UART3_USE_DMA
 			// Enable serial port interrupt
 			IE2 |= M_ES3;
+	#endif // UART3_USE_DMA
 			break;
 
 		case UART4:
@@ -368,16 +992,30 @@ TimerStatus uartInitialise(Uart uart, uint32_t baudRate, UartBaudRateTimer baudR
 			// Set pin configuration
 			P_SW2 = (P_SW2 & ~M_S4_S) | ((pinSwitch << P_S4_S) & M_S4_S);
 			
-			// Set UART mode and clear interrupt flag
-			S4CON = scon;
+			// Set UART mode and clear interrupt flag, keeping the
+			// clock source configured above.
+			S4CON = scon | (S4CON & M_S4ST4);
 			
+	#ifndef UART4_USE_DMA
 			// Enable serial port interrupt
 			IE2 |= M_ES4;
+	#endif // UART4_USE_DMA
 			break;
 #endif // HAL_UARTS >= 3
 		}
 		
 		uartTransmitBuffer(uart)->status = STATUS_CLEAR;
+		uartReceiveBuffer(uart)->status = mode;
+		
+#ifdef UART_DMA_MODE
+		UartDmaState *dmaState = uartDmaState(uart);
+		
+		if (dmaState) {
+			CRITICAL {
+				__uartDmaReceiveNext(uart, uartReceiveBuffer(uart), dmaState);
+			}
+		}
+#endif // UART_DMA_MODE
 	}
 	
 	return rc;
@@ -393,9 +1031,16 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 	
 	if (S1CON & M_TI) {
 		S1CON &= ~M_TI;
+#ifdef UART_STATISTICS
+		UART1_statistics.txBytes++;
+#endif // UART_STATISTICS
 		
-		if (fifoRead(&UART1_transmitBuffer, &c, 1)) {
-			S1BUF = c;
+		if (uartFifoRead(&UART1_transmitBuffer, &c, 1)) {
+			UART1_WRITE_BUFFER(c);
+#ifdef HAL_UART_API_TRANSMIT_QUEUE
+		} else if (uartQueueReadByte(&UART1_transmitQueue, &c)) {
+			UART1_WRITE_BUFFER(c);
+#endif // HAL_UART_API_TRANSMIT_QUEUE
 		} else {
 			UART1_transmitBuffer.status = STATUS_CLEAR;
 		}
@@ -404,7 +1049,66 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 	if (S1CON & M_RI) {
 		S1CON &= ~M_RI;
 		c = S1BUF;
-		fifoWrite(&UART1_receiveBuffer, &c, 1);
+		bool store = true;
+		
+#ifdef UART_STATISTICS
+		// PCON.SMOD0 is set, so SM0 reads as FE. Only UART1 has it.
+		if (S1CON & M_FE) {
+			S1CON &= ~M_FE;
+			UART1_statistics.framingErrors++;
+		}
+#endif // UART_STATISTICS
+		
+		switch (uartMode(UART1_receiveBuffer)) {
+		case UART_8E1:
+		case UART_8O1:
+			// Drop bytes with a parity error.
+			store = uartParityBit(c, uartMode(UART1_receiveBuffer)) == ((S1CON & M_RB8) != 0);
+#ifdef UART_STATISTICS
+			
+			if (!store) {
+				UART1_statistics.parityErrors++;
+			}
+#endif // UART_STATISTICS
+			break;
+		
+		case UART_MULTI_MACHINE:
+			if (S1CON & M_RB8) {
+				// Address byte: select this node (SM2 cleared) or
+				// not. While SM2 is set, the hardware only lets
+				// through addresses matching SADDR and SADEN.
+				store = false;
+				
+				if (uartAddressMatches(c, SADDR, SADEN)) {
+					S1CON &= ~M_SM2;
+				} else {
+					S1CON |= M_SM2;
+				}
+			}
+			break;
+		}
+		
+		if (store) {
+			store = uartFifoWrite(&UART1_receiveBuffer, &c, 1);
+			
+#ifdef UART_STATISTICS
+			if (store) {
+				UART_COUNT_RECEIVED(UART1_statistics, UART1_receiveBuffer);
+			} else {
+				UART1_statistics.rxOverflows++;
+			}
+#endif // UART_STATISTICS
+			
+#ifdef UART1_FRAME_TIMEOUT
+			if (store) {
+				UART1_frameState.length++;
+			}
+			
+			// Restarting the countdown at timeout + 1 guarantees at
+			// least timeout full ticks of silence.
+			UART1_frameState.ticksLeft = UART1_FRAME_TIMEOUT + 1;
+#endif // UART1_FRAME_TIMEOUT
+		}
 	}
 }
 
@@ -414,9 +1118,16 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 		
 		if (S2CON & M_TI) {
 			S2CON &= ~M_TI;
+	#ifdef UART_STATISTICS
+			UART2_statistics.txBytes++;
+	#endif // UART_STATISTICS
 			
-			if (fifoRead(&UART2_transmitBuffer, &c, 1)) {
-				S2BUF = c;
+			if (uartFifoRead(&UART2_transmitBuffer, &c, 1)) {
+				UART2_WRITE_BUFFER(c);
+	#ifdef HAL_UART_API_TRANSMIT_QUEUE
+			} else if (uartQueueReadByte(&UART2_transmitQueue, &c)) {
+				UART2_WRITE_BUFFER(c);
+	#endif // HAL_UART_API_TRANSMIT_QUEUE
 			} else {
 				UART2_transmitBuffer.status = STATUS_CLEAR;
 			}
@@ -425,7 +1136,53 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 		if (S2CON & M_RI) {
 			S2CON &= ~M_RI;
 			c = S2BUF;
-			fifoWrite(&UART2_receiveBuffer, &c, 1);
+			bool store = true;
+			
+			switch (uartMode(UART2_receiveBuffer)) {
+			case UART_8E1:
+			case UART_8O1:
+				store = uartParityBit(c, uartMode(UART2_receiveBuffer)) == ((S2CON & M_RB8) != 0);
+	#ifdef UART_STATISTICS
+				
+				if (!store) {
+					UART2_statistics.parityErrors++;
+				}
+	#endif // UART_STATISTICS
+				break;
+			
+			case UART_MULTI_MACHINE:
+				if (S2CON & M_RB8) {
+					// Address byte: select this node or not.
+					store = false;
+					
+					if (uartAddressMatches(c, UART2_address.address, UART2_address.mask)) {
+						S2CON &= ~M_SM2;
+					} else {
+						S2CON |= M_SM2;
+					}
+				}
+				break;
+			}
+			
+			if (store) {
+				store = uartFifoWrite(&UART2_receiveBuffer, &c, 1);
+				
+	#ifdef UART_STATISTICS
+				if (store) {
+					UART_COUNT_RECEIVED(UART2_statistics, UART2_receiveBuffer);
+				} else {
+					UART2_statistics.rxOverflows++;
+				}
+	#endif // UART_STATISTICS
+				
+	#ifdef UART2_FRAME_TIMEOUT
+				if (store) {
+					UART2_frameState.length++;
+				}
+				
+				UART2_frameState.ticksLeft = UART2_FRAME_TIMEOUT + 1;
+	#endif // UART2_FRAME_TIMEOUT
+			}
 		}
 	}
 #endif // HAL_UARTS >= 2
@@ -436,9 +1193,16 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 		
 		if (S3CON & M_TI) {
 			S3CON &= ~M_TI;
+	#ifdef UART_STATISTICS
+			UART3_statistics.txBytes++;
+	#endif // UART_STATISTICS
 			
-			if (fifoRead(&UART3_transmitBuffer, &c, 1)) {
-				S3BUF = c;
+			if (uartFifoRead(&UART3_transmitBuffer, &c, 1)) {
+				UART3_WRITE_BUFFER(c);
+	#ifdef HAL_UART_API_TRANSMIT_QUEUE
+			} else if (uartQueueReadByte(&UART3_transmitQueue, &c)) {
+				UART3_WRITE_BUFFER(c);
+	#endif // HAL_UART_API_TRANSMIT_QUEUE
 			} else {
 				UART3_transmitBuffer.status = STATUS_CLEAR;
 			}
@@ -447,7 +1211,53 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 		if (S3CON & M_RI) {
 			S3CON &= ~M_RI;
 			c = S3BUF;
-			fifoWrite(&UART3_receiveBuffer, &c, 1);
+			bool store = true;
+			
+			switch (uartMode(UART3_receiveBuffer)) {
+			case UART_8E1:
+			case UART_8O1:
+				store = uartParityBit(c, uartMode(UART3_receiveBuffer)) == ((S3CON & M_RB8) != 0);
+	#ifdef UART_STATISTICS
+				
+				if (!store) {
+					UART3_statistics.parityErrors++;
+				}
+	#endif // UART_STATISTICS
+				break;
+			
+			case UART_MULTI_MACHINE:
+				if (S3CON & M_RB8) {
+					// Address byte: select this node or not.
+					store = false;
+					
+					if (uartAddressMatches(c, UART3_address.address, UART3_address.mask)) {
+						S3CON &= ~M_SM2;
+					} else {
+						S3CON |= M_SM2;
+					}
+				}
+				break;
+			}
+			
+			if (store) {
+				store = uartFifoWrite(&UART3_receiveBuffer, &c, 1);
+				
+	#ifdef UART_STATISTICS
+				if (store) {
+					UART_COUNT_RECEIVED(UART3_statistics, UART3_receiveBuffer);
+				} else {
+					UART3_statistics.rxOverflows++;
+				}
+	#endif // UART_STATISTICS
+				
+	#ifdef UART3_FRAME_TIMEOUT
+				if (store) {
+					UART3_frameState.length++;
+				}
+				
+				UART3_frameState.ticksLeft = UART3_FRAME_TIMEOUT + 1;
+	#endif // UART3_FRAME_TIMEOUT
+			}
 		}
 	}
 
@@ -456,9 +1266,16 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 		
 		if (S4CON & M_TI) {
 			S4CON &= ~M_TI;
+	#ifdef UART_STATISTICS
+			UART4_statistics.txBytes++;
+	#endif // UART_STATISTICS
 			
-			if (fifoRead(&UART4_transmitBuffer, &c, 1)) {
-				S4BUF = c;
+			if (uartFifoRead(&UART4_transmitBuffer, &c, 1)) {
+				UART4_WRITE_BUFFER(c);
+	#ifdef HAL_UART_API_TRANSMIT_QUEUE
+			} else if (uartQueueReadByte(&UART4_transmitQueue, &c)) {
+				UART4_WRITE_BUFFER(c);
+	#endif // HAL_UART_API_TRANSMIT_QUEUE
 			} else {
 				UART4_transmitBuffer.status = STATUS_CLEAR;
 			}
@@ -467,11 +1284,129 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT) {
 		if (S4CON & M_RI) {
 			S4CON &= ~M_RI;
 			c = S4BUF;
-			fifoWrite(&UART4_receiveBuffer, &c, 1);
+			bool store = true;
+			
+			switch (uartMode(UART4_receiveBuffer)) {
+			case UART_8E1:
+			case UART_8O1:
+				store = uartParityBit(c, uartMode(UART4_receiveBuffer)) == ((S4CON & M_RB8) != 0);
+	#ifdef UART_STATISTICS
+				
+				if (!store) {
+					UART4_statistics.parityErrors++;
+				}
+	#endif // UART_STATISTICS
+				break;
+			
+			case UART_MULTI_MACHINE:
+				if (S4CON & M_RB8) {
+					// Address byte: select this node or not.
+					store = false;
+					
+					if (uartAddressMatches(c, UART4_address.address, UART4_address.mask)) {
+						S4CON &= ~M_SM2;
+					} else {
+						S4CON |= M_SM2;
+					}
+				}
+				break;
+			}
+			
+			if (store) {
+				store = uartFifoWrite(&UART4_receiveBuffer, &c, 1);
+				
+	#ifdef UART_STATISTICS
+				if (store) {
+					UART_COUNT_RECEIVED(UART4_statistics, UART4_receiveBuffer);
+				} else {
+					UART4_statistics.rxOverflows++;
+				}
+	#endif // UART_STATISTICS
+				
+	#ifdef UART4_FRAME_TIMEOUT
+				if (store) {
+					UART4_frameState.length++;
+				}
+				
+				UART4_frameState.ticksLeft = UART4_FRAME_TIMEOUT + 1;
+	#endif // UART4_FRAME_TIMEOUT
+			}
 		}
 	}
 #endif // HAL_UARTS >= 3
 
+#ifdef UART1_USE_DMA
+	INTERRUPT(uart1_dma_tx_isr, DMA_UR1T_INTERRUPT) {
+		DMA_UR1T_STA = 0;
+		__uartDmaOnTransmitComplete(UART1, &UART1_transmitBuffer, &UART1_dmaState);
+	}
+	
+	INTERRUPT(uart1_dma_rx_isr, DMA_UR1R_INTERRUPT) {
+	#ifdef UART_STATISTICS
+		if (DMA_UR1R_STA & M_RXLOSS) {
+			UART1_statistics.rxOverflows++;
+		}
+	#endif // UART_STATISTICS
+		
+		DMA_UR1R_STA = 0;
+		__uartDmaOnReceiveComplete(UART1, &UART1_receiveBuffer, &UART1_dmaState);
+	}
+#endif // UART1_USE_DMA
+
+#if HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+	INTERRUPT(uart2_dma_tx_isr, DMA_UR2T_INTERRUPT) {
+		DMA_UR2T_STA = 0;
+		__uartDmaOnTransmitComplete(UART2, &UART2_transmitBuffer, &UART2_dmaState);
+	}
+	
+	INTERRUPT(uart2_dma_rx_isr, DMA_UR2R_INTERRUPT) {
+	#ifdef UART_STATISTICS
+		if (DMA_UR2R_STA & M_RXLOSS) {
+			UART2_statistics.rxOverflows++;
+		}
+	#endif // UART_STATISTICS
+		
+		DMA_UR2R_STA = 0;
+		__uartDmaOnReceiveComplete(UART2, &UART2_receiveBuffer, &UART2_dmaState);
+	}
+#endif // HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+
+#if HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+	INTERRUPT(uart3_dma_tx_isr, DMA_UR3T_INTERRUPT) {
+		DMA_UR3T_STA = 0;
+		__uartDmaOnTransmitComplete(UART3, &UART3_transmitBuffer, &UART3_dmaState);
+	}
+	
+	INTERRUPT(uart3_dma_rx_isr, DMA_UR3R_INTERRUPT) {
+	#ifdef UART_STATISTICS
+		if (DMA_UR3R_STA & M_RXLOSS) {
+			UART3_statistics.rxOverflows++;
+		}
+	#endif // UART_STATISTICS
+		
+		DMA_UR3R_STA = 0;
+		__uartDmaOnReceiveComplete(UART3, &UART3_receiveBuffer, &UART3_dmaState);
+	}
+#endif // HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+
+#if HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+	INTERRUPT(uart4_dma_tx_isr, DMA_UR4T_INTERRUPT) {
+		DMA_UR4T_STA = 0;
+		__uartDmaOnTransmitComplete(UART4, &UART4_transmitBuffer, &UART4_dmaState);
+	}
+	
+	INTERRUPT(uart4_dma_rx_isr, DMA_UR4R_INTERRUPT) {
+	#ifdef UART_STATISTICS
+		if (DMA_UR4R_STA & M_RXLOSS) {
+			UART4_statistics.rxOverflows++;
+		}
+	#endif // UART_STATISTICS
+		
+		DMA_UR4R_STA = 0;
+		__uartDmaOnReceiveComplete(UART4, &UART4_receiveBuffer, &UART4_dmaState);
+	}
+#endif // HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+
 uint8_t uartGetCharacter(Uart uart, BlockingOperation blocking) {
 	uint8_t result = 0;
 	uartGetBlock(uart, &result, 1, blocking);
@@ -481,62 +1416,213 @@ uint8_t uartGetCharacter(Uart uart, BlockingOperation blocking) {
 
 bool uartGetBlock(Uart uart, uint8_t *data, uint8_t size, BlockingOperation blocking) {
 	bool rc = true;
-	FifoState *buffer = uartReceiveBuffer(uart);
+	UartFifo *buffer = uartReceiveBuffer(uart);
+#ifdef UART_DMA_MODE
+	UartDmaState *dmaState = uartDmaState(uart);
+	
+	if (dmaState) {
+		// Bytes received by the DMA transfer in progress are only
+		// committed to the FIFO when it completes, unless we ask.
+		do {
+			CRITICAL {
+				__uartDmaSyncReceive(uart, buffer, dmaState);
+			}
+			
+			rc = uartFifoRead(buffer, data, size);
+		} while (!rc && blocking == BLOCKING);
+		
+		if (rc) {
+			// Reading may have made room for a suspended reception.
+			CRITICAL {
+				__uartDmaSyncReceive(uart, buffer, dmaState);
+			}
+		}
+		
+		return rc;
+	}
+#endif // UART_DMA_MODE
 	
 	if (blocking == BLOCKING) {
-		while (!fifoRead(buffer, data, size));
+		while (!uartFifoRead(buffer, data, size));
 	} else {
-		rc = fifoRead(buffer, data, size);
+		rc = uartFifoRead(buffer, data, size);
 	}
 	
 	return rc;
 }
 
-static void __uartStartSending(Uart uart, FifoState *buffer) {
+static void __uartStartSending(Uart uart, UartFifo *buffer) {
+#ifdef UART_DMA_MODE
+	UartDmaState *dmaState = uartDmaState(uart);
+	
+	if (dmaState) {
+		CRITICAL {
+			// The DMA ISR may have restarted transmission already.
+			if (buffer->status == STATUS_CLEAR) {
+				__uartDmaSendNext(uart, buffer, dmaState);
+			}
+		}
+		
+		return;
+	}
+#endif // UART_DMA_MODE
+	
 	buffer->status = STATUS_SENDING;
 	uint8_t data;
-	fifoRead(buffer, &data, 1);
+	uartFifoRead(buffer, &data, 1);
+	uartWriteBuffer(uart, data);
+}
+
+bool uartSendCharacter(Uart uart, uint8_t c, BlockingOperation blocking) {
+	return uartSendBlock(uart, &c, 1, blocking);
+}
+
+uint16_t uartSendBlockPartial(Uart uart, const uint8_t *data, uint16_t size) {
+	UartFifo *buffer = uartTransmitBuffer(uart);
+	UartFifoSize count = uartFifoBytesFree(buffer);
+	
+	if (count > size) {
+		count = size;
+	}
+	
+	if (count) {
+		uartFifoWrite(buffer, data, count);
+		
+		if (buffer->status == STATUS_CLEAR) {
+			__uartStartSending(uart, buffer);
+		}
+	}
+	
+	return count;
+}
+
+bool uartSendBlock(Uart uart, const uint8_t *data, uint8_t size, BlockingOperation blocking) {
+	UartFifo *buffer = uartTransmitBuffer(uart);
+	bool rc = true;
+	
+	if (blocking == BLOCKING) {
+		// Stream the block in chunks so it needn't fit in the buffer.
+		while (size) {
+			uint8_t count = uartSendBlockPartial(uart, data, size);
+			data += count;
+			size -= count;
+		}
+	} else {
+		rc = uartFifoWrite(buffer, data, size);
+		
+		if (rc && buffer->status == STATUS_CLEAR) {
+			__uartStartSending(uart, buffer);
+		}
+	}
 	
+	return rc;
+}
+
+void uartSetAddress(Uart uart, uint8_t address, uint8_t mask) {
 	switch (uart) {
 	case UART1:
-		S1BUF = data;
+		SADDR = address;
+		SADEN = mask;
 		break;
 	
 #if HAL_UARTS >= 2
 	case UART2:
-		S2BUF = data;
+		UART2_address.address = address;
+		UART2_address.mask = mask;
 		break;
 #endif // HAL_UARTS >= 2
-	
+
 #if HAL_UARTS >= 3
 	case UART3:
-		S3BUF = data;
+		UART3_address.address = address;
+		UART3_address.mask = mask;
 		break;
 	
 	case UART4:
-		S4BUF = data;
+		UART4_address.address = address;
+		UART4_address.mask = mask;
 		break;
 #endif // HAL_UARTS >= 3
 	}
 }
 
-bool uartSendCharacter(Uart uart, uint8_t c, BlockingOperation blocking) {
-	return uartSendBlock(uart, &c, 1, blocking);
-}
+void uartSendAddress(Uart uart, uint8_t address) {
+	UartFifo *buffer = uartTransmitBuffer(uart);
+	
+	// The 9th bit can't go through the transmit buffer, so wait for
+	// pending data to be sent. The ISR clears TB8 for the next byte.
+	while (buffer->status != STATUS_CLEAR);
+	
+	buffer->status = STATUS_SENDING;
+	
+	switch (uart) {
+	case UART1:
+		S1CON |= M_TB8;
+		S1BUF = address;
+		break;
+	
+#if HAL_UARTS >= 2
+	case UART2:
+		S2CON |= M_TB8;
+		S2BUF = address;
+		break;
+#endif // HAL_UARTS >= 2
 
-bool uartSendBlock(Uart uart, const uint8_t *data, uint8_t size, BlockingOperation blocking) {
-	FifoState *buffer = uartTransmitBuffer(uart);
-	bool rc = true;
+#if HAL_UARTS >= 3
+	case UART3:
+		S3CON |= M_TB8;
+		S3BUF = address;
+		break;
 	
-	if (blocking == BLOCKING) {
-		while (!fifoWrite(buffer, data, size));
-	} else {
-		rc = fifoWrite(buffer, data, size);
+	case UART4:
+		S4CON |= M_TB8;
+		S4BUF = address;
+		break;
+#endif // HAL_UARTS >= 3
 	}
-	
-	if (rc && buffer->status == STATUS_CLEAR) {
-		__uartStartSending(uart, buffer);
+}
+
+#ifdef HAL_UART_API_TRANSMIT_QUEUE
+	void uartSendDescriptor(Uart uart, UartTransmitDescriptor *descriptor) {
+		UartTransmitQueue *queue = uartTransmitQueue(uart);
+		UartFifo *buffer = uartTransmitBuffer(uart);
+		uint8_t c;
+		
+		descriptor->next = NULL;
+		descriptor->complete = descriptor->size == 0;
+		
+		if (!descriptor->complete) {
+			CRITICAL {
+				if (queue->head) {
+					queue->tail->next = descriptor;
+				} else {
+					queue->head = descriptor;
+				}
+				
+				queue->tail = descriptor;
+				
+				if (buffer->status == STATUS_CLEAR) {
+					buffer->status = STATUS_SENDING;
+					uartQueueReadByte(queue, &c);
+					uartWriteBuffer(uart, c);
+				}
+			}
+		}
+	}
+#endif // HAL_UART_API_TRANSMIT_QUEUE
+
+#ifdef UART_STATISTICS
+	void uartGetStatistics(Uart uart, UartStatistics *statistics) {
+		CRITICAL {
+			*statistics = *uartStatistics(uart);
+		}
 	}
 	
-	return rc;
-}
+	void uartClearStatistics(Uart uart) {
+		UartStatistics *statistics = uartStatistics(uart);
+		
+		CRITICAL {
+			memset(statistics, 0, sizeof(UartStatistics));
+		}
+	}
+#endif // UART_STATISTICS
@@ -58,6 +58,12 @@
  *     UART_DEFAULT_BUFFER_SIZE (default: 16) defines the default size
  *     for UART RX and TX buffers. Impacts RAM footprint.
  * 
+ *     UART_STATISTICS (default: undefined) enables per-UART counters,
+ *     see uartGetStatistics(). Impacts ISR execution time.
+ * 
+ *     HAL_UART_API_TRANSMIT_QUEUE (default: undefined) enables
+ *     uartSendDescriptor(). See "Transmit queue" below.
+ * 
  * Optional per-UART macros, with <n> in [1, HAL_UARTS]:
  * 
  *     UART<n>_TX_BUFFER_SIZE (default: UART_DEFAULT_BUFFER_SIZE)
@@ -69,6 +75,78 @@
  *     UART<n>_SEGMENT (default: UART_DEFAULT_SEGMENT) defines where
  *     the HAL's state information for UART<n> will be stored.
  * 
+ *     UART<n>_USE_DMA (default: undefined, requires MCU_HAS_DMA) makes
+ *     UART<n> transmit and receive through DMA instead of taking one
+ *     interrupt per byte. See "DMA mode" below.
+ * 
+ *     UART<n>_FRAME_TIMEOUT (default: undefined) enables idle-line
+ *     frame detection on UART<n>, with a timeout of the given number
+ *     of character times in [1; 254]. See "Frame detection" below.
+ * 
+ * Buffer sizes up to 65534 bytes are supported. However, as soon as
+ * one of them is larger than 255 bytes, all UARTs use 16-bit indexed
+ * FIFOs (FifoState16), which are a little slower. Such buffers will
+ * most likely need to be stored in __xdata.
+ * 
+ * DMA mode:
+ * 
+ * The receive FIFO is filled in place by the UART's receive DMA
+ * channel, which is restarted continuously on the next contiguous free
+ * span of the FIFO. Received bytes are made available to uartGetBlock()
+ * and uartGetCharacter() as soon as they've been transferred. When the
+ * FIFO is full, reception is suspended until the application reads
+ * data, and bytes received in the meantime are lost.
+ * 
+ * The transmit FIFO is drained by the UART's transmit DMA channel.
+ * uartSendBlockDma() additionally sends a caller-owned block (without
+ * copying it to the FIFO) and calls uartOnDmaTransmitComplete() once
+ * it has been sent entirely.
+ * 
+ * DMA can only access __xdata, so buffers and blocks MUST be located
+ * there. The default segment is __xdata when DMA mode is used.
+ * 
+ * 9-bit modes:
+ * 
+ * In UART_8E1 and UART_8O1 modes, the 9th bit carries the parity,
+ * which is generated on transmission and checked on reception. Bytes
+ * with a parity error are dropped.
+ * 
+ * In UART_MULTI_MACHINE mode, a node only receives the data bytes
+ * following an address byte (see uartSendAddress()) matching its own
+ * address or the broadcast address (see uartSetAddress()). Data bytes
+ * sent to other nodes don't trigger any interrupt, and neither do
+ * non-matching address bytes on UART1, which has hardware address
+ * recognition. Address bytes aren't stored in the receive buffer.
+ * 
+ * 9-bit modes aren't supported in DMA mode.
+ * 
+ * Transmit queue:
+ * 
+ * When HAL_UART_API_TRANSMIT_QUEUE is defined, uartSendDescriptor()
+ * queues a caller-owned block for sending without copying it to the
+ * transmit buffer: the ISR reads it directly, wherever it's located
+ * (including __code). Queued blocks are sent whenever the transmit
+ * buffer is empty, so bytes sent with uartSendBlock() in the meantime
+ * go first. The transmit queue isn't supported in DMA mode, where
+ * uartSendBlockDma() serves the same purpose.
+ * 
+ * Frame detection:
+ * 
+ * Protocols such as Modbus RTU delimit frames with line silence.
+ * Silence is measured in ticks of a timer started with
+ * uartStartFrameTimer(), whose period is one character time (10 bits)
+ * at the given baud rate. The application's ISR for this timer MUST
+ * call uartFrameTimerTick().
+ * 
+ * Once UART<n>_FRAME_TIMEOUT character times have elapsed without
+ * receiving anything, uartOnFrameReceived() is called with the number
+ * of bytes received since the previous frame, which are waiting in
+ * the receive buffer. The timeout is only accurate to one tick, and
+ * is rounded up.
+ * 
+ * The timer ISR and the UART ISRs MUST have the same priority, and
+ * frame detection isn't supported in DMA mode.
+ * 
  * **IMPORTANT:** In order to satisfy SDCC's requirements for ISR 
  * handling, this header file **MUST** be included in the C source 
  * file where main() is defined.
@@ -89,6 +167,14 @@
 	#define HAL_UARTS 1
 #endif
 
+#if defined(UART1_USE_DMA) || defined(UART2_USE_DMA) || defined(UART3_USE_DMA) || defined(UART4_USE_DMA)
+	#ifndef MCU_HAS_DMA
+		#error "UART<n>_USE_DMA requires an MCU with DMA"
+	#endif // MCU_HAS_DMA
+	
+	#define UART_DMA_MODE
+#endif
+
 #include <hal-defs.h>
 #include <timer-hal.h>
 
@@ -182,8 +268,136 @@ bool uartGetBlock(Uart uart, uint8_t *data, uint8_t size, BlockingOperation bloc
 
 bool uartSendCharacter(Uart uart, uint8_t c, BlockingOperation blocking);
 
+/**
+ * When blocking is BLOCKING, data is fed to the transmit buffer as
+ * space frees up, so size may exceed the buffer size.
+ * Otherwise, returns false without sending anything unless the whole
+ * block fits in the transmit buffer.
+ */
 bool uartSendBlock(Uart uart, const uint8_t *data, uint8_t size, BlockingOperation blocking);
 
+/**
+ * Copies as many bytes of data as currently fit in the transmit buffer
+ * and returns their number, without ever waiting. The caller resumes
+ * with the remaining bytes later on, which allows streaming records
+ * larger than the transmit buffer from the main loop.
+ */
+uint16_t uartSendBlockPartial(Uart uart, const uint8_t *data, uint16_t size);
+
+/**
+ * Sets the address of uart in UART_MULTI_MACHINE mode. Bits cleared
+ * in mask are "don't care", and address | mask is the broadcast
+ * address, as with the SADDR and SADEN registers of the 8051.
+ */
+void uartSetAddress(Uart uart, uint8_t address, uint8_t mask);
+
+/**
+ * Sends an address byte (9th bit set) in UART_MULTI_MACHINE mode,
+ * once the transmit buffer is empty. Data bytes sent afterwards are
+ * received by the nodes this address selects.
+ */
+void uartSendAddress(Uart uart, uint8_t address);
+
+#ifdef UART_STATISTICS
+	typedef struct {
+		uint32_t rxBytes; /*!< Bytes stored in the receive buffer. */
+		uint32_t txBytes; /*!< Bytes sent. */
+		uint16_t rxOverflows; /*!< Bytes lost because the receive buffer was full. */
+		uint16_t framingErrors; /*!< Bytes without a valid stop bit (UART1 only). */
+		uint16_t parityErrors; /*!< Bytes dropped in UART_8E1 and UART_8O1 modes. */
+		uint16_t rxHighWaterMark; /*!< Maximum number of bytes in the receive buffer. */
+	} UartStatistics;
+	
+	/**
+	 * Copies uart's counters to statistics.
+	 * 
+	 * Only UART1 can detect framing errors. In DMA mode, rxOverflows
+	 * doesn't count bytes lost while reception is suspended.
+	 */
+	void uartGetStatistics(Uart uart, UartStatistics *statistics);
+	
+	void uartClearStatistics(Uart uart);
+#endif // UART_STATISTICS
+
+#ifdef HAL_UART_API_TRANSMIT_QUEUE
+	#ifdef UART_DMA_MODE
+		#error "The transmit queue isn't supported in DMA mode"
+	#endif // UART_DMA_MODE
+	
+	typedef struct UartTransmitDescriptor {
+		const uint8_t *data; /*!< Next byte to send (generic pointer). */
+		uint16_t size; /*!< Number of bytes left to send. */
+		volatile bool complete; /*!< Set once all bytes have been sent. */
+		struct UartTransmitDescriptor *next; /*!< Reserved for the HAL. */
+	} UartTransmitDescriptor;
+	
+	/**
+	 * Queues descriptor for sending, and returns immediately. The HAL
+	 * updates data and size as bytes are sent, so the descriptor and
+	 * the bytes it points to MUST remain untouched until complete is
+	 * set.
+	 */
+	void uartSendDescriptor(Uart uart, UartTransmitDescriptor *descriptor);
+#endif // HAL_UART_API_TRANSMIT_QUEUE
+
+#if defined(UART1_FRAME_TIMEOUT) || defined(UART2_FRAME_TIMEOUT) || defined(UART3_FRAME_TIMEOUT) || defined(UART4_FRAME_TIMEOUT)
+	#ifdef UART_DMA_MODE
+		#error "Frame detection isn't supported in DMA mode"
+	#endif // UART_DMA_MODE
+	
+	#define UART_FRAME_MODE
+#endif
+
+#ifdef UART_FRAME_MODE
+	/**
+	 * Starts timer with a period of one character time at baudRate
+	 * and its interrupt enabled. When UARTs use different baud rates,
+	 * the highest one should be used.
+	 */
+	TimerStatus uartStartFrameTimer(Timer timer, uint32_t baudRate);
+	
+	/**
+	 * MUST be called from the frame timer's ISR.
+	 */
+	void uartFrameTimerTick(void);
+	
+	/**
+	 * The following event handler MUST be implemented. It's called
+	 * from the frame timer's ISR when length bytes followed by
+	 * UART<n>_FRAME_TIMEOUT character times of silence have been
+	 * received by uart.
+	 */
+	void uartOnFrameReceived(Uart uart, uint16_t length);
+#endif // UART_FRAME_MODE
+
+#ifdef UART_DMA_MODE
+	/**
+	 * Sends size bytes from data through DMA, without copying them.
+	 * data MUST remain untouched until uartOnDmaTransmitComplete() is
+	 * called. Only one block per UART can be pending at any time: when
+	 * a block is already pending, returns false unless blocking is
+	 * BLOCKING, in which case it waits for it to complete. When size
+	 * is 0, uartOnDmaTransmitComplete() is called right away, from the
+	 * caller's context.
+	 * 
+	 * The block is sent after the DMA transfer in progress, if any, so
+	 * it may overtake bytes still waiting in the transmit FIFO.
+	 */
+	bool uartSendBlockDma(Uart uart, const __xdata uint8_t *data, uint16_t size, BlockingOperation blocking);
+	
+	/**
+	 * The following event handlers MUST be implemented, even when not
+	 * used. They're called from the DMA ISR.
+	 */
+	
+	// A block passed to uartSendBlockDma() has been sent entirely.
+	void uartOnDmaTransmitComplete(Uart uart);
+	
+	// A receive DMA transfer has completed, i.e. count bytes (never 0)
+	// have been added to the receive FIFO since the previous call.
+	void uartOnDmaDataReceived(Uart uart, uint8_t count);
+#endif // UART_DMA_MODE
+
 INTERRUPT(uart1_isr, UART1_INTERRUPT);
 
 #if HAL_UARTS >= 2
@@ -195,4 +409,24 @@ INTERRUPT(uart1_isr, UART1_INTERRUPT);
 	INTERRUPT(uart4_isr, UART4_INTERRUPT);
 #endif // HAL_UARTS >= 3
 
+#ifdef UART1_USE_DMA
+	INTERRUPT(uart1_dma_tx_isr, DMA_UR1T_INTERRUPT);
+	INTERRUPT(uart1_dma_rx_isr, DMA_UR1R_INTERRUPT);
+#endif // UART1_USE_DMA
+
+#if HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+	INTERRUPT(uart2_dma_tx_isr, DMA_UR2T_INTERRUPT);
+	INTERRUPT(uart2_dma_rx_isr, DMA_UR2R_INTERRUPT);
+#endif // HAL_UARTS >= 2 && defined(UART2_USE_DMA)
+
+#if HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+	INTERRUPT(uart3_dma_tx_isr, DMA_UR3T_INTERRUPT);
+	INTERRUPT(uart3_dma_rx_isr, DMA_UR3R_INTERRUPT);
+#endif // HAL_UARTS >= 3 && defined(UART3_USE_DMA)
+
+#if HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+	INTERRUPT(uart4_dma_tx_isr, DMA_UR4T_INTERRUPT);
+	INTERRUPT(uart4_dma_rx_isr, DMA_UR4R_INTERRUPT);
+#endif // HAL_UARTS >= 3 && defined(UART4_USE_DMA)
+
 #endif // _UART_HAL_H
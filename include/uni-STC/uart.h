@@ -61,6 +61,10 @@ SBIT(S1SM0_FE, 0x98, 7);
 #define M_SM0 0x80
 #define P_SM0 7
 
+// Only for S1CON, replaces SM0 when PCON.SMOD0 is set.
+#define M_FE 0x80
+#define P_FE 7
+
 // Only for S1CON. UART1 is the only one with 4 modes of operation.
 #define M_SM1 0x40
 #define P_SM1 6
@@ -203,9 +207,12 @@ SFR(S1BUF, 0x99);
 
 	// SFR DMA_UR1T_STA: UART1 Transmit DMA status register
 	SFRX(DMA_UR1T_STA, 0xFA32);
+	
+	#define M_TXOVW 0x04
+	#define P_TXOVW 2
 
 	// SFR DMA_UR1T_AMT: UART1 Transmit DMA total bytes to be transferred
-	SFRX(DMA_URTX_AMT, 0xFA33);
+	SFRX(DMA_UR1T_AMT, 0xFA33);
 
 	// SFR DMA_UR1T_DONE: UART1 Transmit DMA transfer completed bytes
 	SFRX(DMA_UR1T_DONE, 0xFA34);
@@ -227,9 +234,14 @@ SFR(S1BUF, 0x99);
 	
 	#define M_TRIG_RX 0x20
 	#define P_TRIG_RX 5
+	
+	// M_CLRFIFO is defined in spi.h
 
 	// SFR DMA_UR1R_STA: UART1 Receive DMA status register
 	SFRX(DMA_UR1R_STA, 0xFA3A);
+	
+	#define M_RXLOSS 0x02
+	#define P_RXLOSS 1
 
 	// SFR DMA_UR1R_AMT: UART1 Receive DMA total bytes to be transferred
 	SFRX(DMA_UR1R_AMT, 0xFA3B);
@@ -237,10 +249,10 @@ SFR(S1BUF, 0x99);
 	// SFR DMA_UR1R_DONE: UART1 Receive DMA transfer completed bytes
 	SFRX(DMA_UR1R_DONE, 0xFA3C);
 
-	// SFR DMA_UR1R_TXAH: UART1 Receive DMA send address high
-	SFRX(DMA_UR1R_TXAH, 0xFA3D);
-	// SFR DMA_UR1R_TXAL: UART1 Receive DMA send address low
-	SFRX(DMA_UR1R_TXAL, 0xFA3E);
+	// SFR DMA_UR1R_RXAH: UART1 Receive DMA receive address high
+	SFRX(DMA_UR1R_RXAH, 0xFA3D);
+	// SFR DMA_UR1R_RXAL: UART1 Receive DMA receive address low
+	SFRX(DMA_UR1R_RXAL, 0xFA3E);
 	
 	// UART1 receive DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 	#define DMA_UR1R_INTERRUPT 51
@@ -248,48 +260,48 @@ SFR(S1BUF, 0x99);
 
 	#if NB_UARTS >= 2
 		// SFR DMA_UR2T_CFG: UART2 Transmit DMA configuration register
-		SFRX(DMA_UR2T_CFG, 0xFA30);
+		SFRX(DMA_UR2T_CFG, 0xFA40);
 
 		// SFR DMA_UR2T_CR: UART2 Transmit DMA control register
-		SFRX(DMA_UR2T_CR, 0xFA31);
+		SFRX(DMA_UR2T_CR, 0xFA41);
 
 		// SFR DMA_UR2T_STA: UART2 Transmit DMA status register
-		SFRX(DMA_UR2T_STA, 0xFA32);
+		SFRX(DMA_UR2T_STA, 0xFA42);
 
 		// SFR DMA_UR2T_AMT: UART2 Transmit DMA total bytes to be transferred
-		SFRX(DMA_UR2T_AMT, 0xFA33);
+		SFRX(DMA_UR2T_AMT, 0xFA43);
 
 		// SFR DMA_UR2T_DONE: UART2 Transmit DMA transfer completed bytes
-		SFRX(DMA_UR2T_DONE, 0xFA34);
+		SFRX(DMA_UR2T_DONE, 0xFA44);
 
 		// SFR DMA_UR2T_TXAH: UART2 Transmit DMA send address high
-		SFRX(DMA_UR2T_TXAH, 0xFA35);
+		SFRX(DMA_UR2T_TXAH, 0xFA45);
 		// SFR DMA_UR2T_TXAL: UART2 Transmit DMA send address low
-		SFRX(DMA_UR2T_TXAL, 0xFA36);
+		SFRX(DMA_UR2T_TXAL, 0xFA46);
 
 		// UART2 transmit DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 		#define DMA_UR2T_INTERRUPT 52
 		#define DMA_UR2T_VECTOR_ADDR 0x01A3
 
 		// SFR DMA_UR2R_CFG: UART2 Receive DMA configuration register
-		SFRX(DMA_UR2R_CFG, 0xFA38);
+		SFRX(DMA_UR2R_CFG, 0xFA48);
 
 		// SFR DMA_UR2R_CR: UART2 Receive DMA control register
-		SFRX(DMA_UR2R_CR, 0xFA39);
+		SFRX(DMA_UR2R_CR, 0xFA49);
 
 		// SFR DMA_UR2R_STA: UART2 Receive DMA status register
-		SFRX(DMA_UR2R_STA, 0xFA3A);
+		SFRX(DMA_UR2R_STA, 0xFA4A);
 
 		// SFR DMA_UR2R_AMT: UART2 Receive DMA total bytes to be transferred
-		SFRX(DMA_UR2R_AMT, 0xFA3B);
+		SFRX(DMA_UR2R_AMT, 0xFA4B);
 
 		// SFR DMA_UR2R_DONE: UART2 Receive DMA transfer completed bytes
-		SFRX(DMA_UR2R_DONE, 0xFA3C);
+		SFRX(DMA_UR2R_DONE, 0xFA4C);
 
-		// SFR DMA_UR2R_TXAH: UART2 Receive DMA send address high
-		SFRX(DMA_UR2R_TXAH, 0xFA3D);
-		// SFR DMA_UR2R_TXAL: UART2 Receive DMA send address low
-		SFRX(DMA_UR2R_TXAL, 0xFA3E);
+		// SFR DMA_UR2R_RXAH: UART2 Receive DMA receive address high
+		SFRX(DMA_UR2R_RXAH, 0xFA4D);
+		// SFR DMA_UR2R_RXAL: UART2 Receive DMA receive address low
+		SFRX(DMA_UR2R_RXAL, 0xFA4E);
 		
 		// UART2 receive DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 		#define DMA_UR2R_INTERRUPT 53
@@ -298,96 +310,96 @@ SFR(S1BUF, 0x99);
 
 	#if NB_UARTS >= 3
 		// SFR DMA_UR3T_CFG: UART3 Transmit DMA configuration register
-		SFRX(DMA_UR3T_CFG, 0xFA30);
+		SFRX(DMA_UR3T_CFG, 0xFA50);
 
 		// SFR DMA_UR3T_CR: UART3 Transmit DMA control register
-		SFRX(DMA_UR3T_CR, 0xFA31);
+		SFRX(DMA_UR3T_CR, 0xFA51);
 
 		// SFR DMA_UR3T_STA: UART3 Transmit DMA status register
-		SFRX(DMA_UR3T_STA, 0xFA32);
+		SFRX(DMA_UR3T_STA, 0xFA52);
 
 		// SFR DMA_UR3T_AMT: UART3 Transmit DMA total bytes to be transferred
-		SFRX(DMA_UR3T_AMT, 0xFA33);
+		SFRX(DMA_UR3T_AMT, 0xFA53);
 
 		// SFR DMA_UR3T_DONE: UART3 Transmit DMA transfer completed bytes
-		SFRX(DMA_UR3T_DONE, 0xFA34);
+		SFRX(DMA_UR3T_DONE, 0xFA54);
 
 		// SFR DMA_UR3T_TXAH: UART3 Transmit DMA send address high
-		SFRX(DMA_UR3T_TXAH, 0xFA35);
+		SFRX(DMA_UR3T_TXAH, 0xFA55);
 		// SFR DMA_UR3T_TXAL: UART3 Transmit DMA send address low
-		SFRX(DMA_UR3T_TXAL, 0xFA36);
+		SFRX(DMA_UR3T_TXAL, 0xFA56);
 
 		// UART3 transmit DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 		#define DMA_UR3T_INTERRUPT 54
 		#define DMA_UR3T_VECTOR_ADDR 0x01B3
 
 		// SFR DMA_UR3R_CFG: UART3 Receive DMA configuration register
-		SFRX(DMA_UR3R_CFG, 0xFA38);
+		SFRX(DMA_UR3R_CFG, 0xFA58);
 
 		// SFR DMA_UR3R_CR: UART3 Receive DMA control register
-		SFRX(DMA_UR3R_CR, 0xFA39);
+		SFRX(DMA_UR3R_CR, 0xFA59);
 
 		// SFR DMA_UR3R_STA: UART3 Receive DMA status register
-		SFRX(DMA_UR3R_STA, 0xFA3A);
+		SFRX(DMA_UR3R_STA, 0xFA5A);
 
 		// SFR DMA_UR3R_AMT: UART3 Receive DMA total bytes to be transferred
-		SFRX(DMA_UR3R_AMT, 0xFA3B);
+		SFRX(DMA_UR3R_AMT, 0xFA5B);
 
 		// SFR DMA_UR3R_DONE: UART3 Receive DMA transfer completed bytes
-		SFRX(DMA_UR3R_DONE, 0xFA3C);
+		SFRX(DMA_UR3R_DONE, 0xFA5C);
 
-		// SFR DMA_UR3R_TXAH: UART3 Receive DMA send address high
-		SFRX(DMA_UR3R_TXAH, 0xFA3D);
-		// SFR DMA_UR3R_TXAL: UART3 Receive DMA send address low
-		SFRX(DMA_UR3R_TXAL, 0xFA3E);
+		// SFR DMA_UR3R_RXAH: UART3 Receive DMA receive address high
+		SFRX(DMA_UR3R_RXAH, 0xFA5D);
+		// SFR DMA_UR3R_RXAL: UART3 Receive DMA receive address low
+		SFRX(DMA_UR3R_RXAL, 0xFA5E);
 		
 		// UART3 receive DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 		#define DMA_UR3R_INTERRUPT 55
 		#define DMA_UR3R_VECTOR_ADDR 0x01BB
 
 		// SFR DMA_UR4T_CFG: UART4 Transmit DMA configuration register
-		SFRX(DMA_UR4T_CFG, 0xFA30);
+		SFRX(DMA_UR4T_CFG, 0xFA60);
 
 		// SFR DMA_UR4T_CR: UART4 Transmit DMA control register
-		SFRX(DMA_UR4T_CR, 0xFA31);
+		SFRX(DMA_UR4T_CR, 0xFA61);
 
 		// SFR DMA_UR4T_STA: UART4 Transmit DMA status register
-		SFRX(DMA_UR4T_STA, 0xFA32);
+		SFRX(DMA_UR4T_STA, 0xFA62);
 
 		// SFR DMA_UR4T_AMT: UART4 Transmit DMA total bytes to be transferred
-		SFRX(DMA_UR4T_AMT, 0xFA33);
+		SFRX(DMA_UR4T_AMT, 0xFA63);
 
 		// SFR DMA_UR4T_DONE: UART4 Transmit DMA transfer completed bytes
-		SFRX(DMA_UR4T_DONE, 0xFA34);
+		SFRX(DMA_UR4T_DONE, 0xFA64);
 
 		// SFR DMA_UR4T_TXAH: UART4 Transmit DMA send address high
-		SFRX(DMA_UR4T_TXAH, 0xFA35);
+		SFRX(DMA_UR4T_TXAH, 0xFA65);
 		// SFR DMA_UR4T_TXAL: UART4 Transmit DMA send address low
-		SFRX(DMA_UR4T_TXAL, 0xFA36);
+		SFRX(DMA_UR4T_TXAL, 0xFA66);
 
 		// UART4 transmit DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 		#define DMA_UR4T_INTERRUPT 56
 		#define DMA_UR4T_VECTOR_ADDR 0x01C3
 
 		// SFR DMA_UR4R_CFG: UART4 Receive DMA configuration register
-		SFRX(DMA_UR4R_CFG, 0xFA38);
+		SFRX(DMA_UR4R_CFG, 0xFA68);
 
 		// SFR DMA_UR4R_CR: UART4 Receive DMA control register
-		SFRX(DMA_UR4R_CR, 0xFA39);
+		SFRX(DMA_UR4R_CR, 0xFA69);
 
 		// SFR DMA_UR4R_STA: UART4 Receive DMA status register
-		SFRX(DMA_UR4R_STA, 0xFA3A);
+		SFRX(DMA_UR4R_STA, 0xFA6A);
 
 		// SFR DMA_UR4R_AMT: UART4 Receive DMA total bytes to be transferred
-		SFRX(DMA_UR4R_AMT, 0xFA3B);
+		SFRX(DMA_UR4R_AMT, 0xFA6B);
 
 		// SFR DMA_UR4R_DONE: UART4 Receive DMA transfer completed bytes
-		SFRX(DMA_UR4R_DONE, 0xFA3C);
+		SFRX(DMA_UR4R_DONE, 0xFA6C);
 
-		// SFR DMA_UR4R_TXAH: UART4 Receive DMA send address high
-		SFRX(DMA_UR4R_TXAH, 0xFA3D);
-		// SFR DMA_UR4R_TXAL: UART4 Receive DMA send address low
-		SFRX(DMA_UR4R_TXAL, 0xFA3E);
+		// SFR DMA_UR4R_RXAH: UART4 Receive DMA receive address high
+		SFRX(DMA_UR4R_RXAH, 0xFA6D);
+		// SFR DMA_UR4R_RXAL: UART4 Receive DMA receive address low
+		SFRX(DMA_UR4R_RXAL, 0xFA6E);
 		
 		// UART4 receive DMA interrupt (usage in C => see STC8H TRM appendix R or STC8A8K64D4 TRM appendix P)
 		#define DMA_UR4R_INTERRUPT 57